@@ -6,22 +6,38 @@
 //
 //===----------------------------------------------------------------------===//
 #include "llvm/Transforms/Utils/LocalOpts.h"
+#include "llvm/Transforms/Utils/PassCache.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/TimeProfiler.h"
 #include <cmath>
 
 // L'include seguente va in LocalOpts.h
 #include <llvm/IR/Constants.h>
 using namespace llvm;
+
+#define DEBUG_TYPE "localopts"
+
+STATISTIC(NumAlgebraicIdentity, "Identita' algebriche eliminate (x+0, x*1)");
+STATISTIC(NumMulToShift, "Moltiplicazioni per potenze di due trasformate in shl");
+STATISTIC(NumMulToShiftAddSub, "Moltiplicazioni trasformate in shl seguito da add/sub");
+STATISTIC(NumDivToShift, "Divisioni per potenze di due trasformate in ashr");
+STATISTIC(NumMultiInstruction, "Coppie add/sub con la stessa costante eliminate");
+
 //Dichiarazione della funzione
-int is_Near_Power_Of_Two(int num);
+int is_Near_Power_Of_Two(int num, unsigned maxDist);
 
+// Restituisce true se ha riscritto almeno una coppia
 bool multiInstructionOptimization(BasicBlock &B) {
+  bool Changed = false;
   for(auto &I : B) {
     Instruction &Inst = I;
-    if(Inst.getOpcode() == 17) return false;
+    if(Inst.getOpcode() == 17) return Changed;
     if(Inst.getNextNode() != nullptr) {
       unsigned int opcode = -1;
       ConstantInt *value = nullptr;
@@ -44,18 +60,21 @@ bool multiInstructionOptimization(BasicBlock &B) {
           for(auto *Iter = InstJ->op_begin(); Iter != InstJ->op_end(); ++Iter) {
             if(ConstantInt *C = dyn_cast<ConstantInt>(Iter)) {
               if(C != value) break;
-              APInt app(32, 0);
-              ConstantInt *CC = ConstantInt::get(value->getType()->getContext(), app);
+              // la costante deve avere il tipo di var (i32, i64, ...)
+              Constant *CC = ConstantInt::get(var->getType(), 0);
               Instruction *TempInst = BinaryOperator::Create(Instruction::Add, var, CC);
               TempInst->insertAfter(InstJ);
               InstJ->replaceAllUsesWith(TempInst);
+              Changed = true;
+              ++NumMultiInstruction;
+              LLVM_DEBUG(dbgs() << "localopts: " << *InstJ << " annulla " << Inst << "\n");
             }
           }
          }
         }
        }
       }
-  return true;
+  return Changed;
 }
 
 bool algebraicIdentity(Instruction &Inst1st, bool add){
@@ -69,6 +88,8 @@ bool algebraicIdentity(Instruction &Inst1st, bool add){
             StoreInst *storeInst = new StoreInst(Inst1st.getOperand(i), ptr, &Inst2st);
             LoadInst *loadInst = new LoadInst(Inst1st.getOperand(i)->getType(), ptr, "", &Inst2st);
             Inst1st.replaceAllUsesWith(loadInst);
+            ++NumAlgebraicIdentity;
+            LLVM_DEBUG(dbgs() << "localopts: identita' " << Inst1st << "\n");
             return true;
 
         }
@@ -78,68 +99,81 @@ bool algebraicIdentity(Instruction &Inst1st, bool add){
   return false;
 }
 
-void strengthReduction(Instruction &Inst1st, bool mul){
+bool strengthReduction(Instruction &Inst1st, bool mul, const LocalOptsOptions &Opts){
+  bool Changed = false;
   int i=1;
   Instruction *ShiftInst;
   for(auto *Iter = Inst1st.op_begin(); Iter != Inst1st.op_end(); ++Iter){
         Value *Op = *Iter;
         if(ConstantInt *C = dyn_cast<ConstantInt>(Op)){
             if (mul)
-		{ int val=is_Near_Power_Of_Two(C->getValue().getSExtValue());
+		{ int val=is_Near_Power_Of_Two(C->getValue().getSExtValue(), Opts.NearPow2Dist);
 		  if(val != -1)	{
-                    APInt app(32, val);
-                    ConstantInt *CC = ConstantInt::get(Inst1st.getOperand(i)->getType()->getContext(), app);
+                    Constant *CC = ConstantInt::get(Inst1st.getOperand(i)->getType(), val);
                     ShiftInst = BinaryOperator::Create(Instruction::Shl, Inst1st.getOperand(i), CC);
 		    ShiftInst->insertAfter(&Inst1st);
-		    if (C->getValue().getSExtValue() < pow(2, val)) {
-                        Instruction *SubInst = BinaryOperator::Create(Instruction::Sub, ShiftInst, Inst1st.getOperand(i));
-                        SubInst->insertAfter(ShiftInst);
-			Inst1st.replaceAllUsesWith(SubInst);
-                    }       
-                    else if (C->getValue().getSExtValue() > pow(2, val)) {
-                        Instruction *AddInst = BinaryOperator::Create(Instruction::Add, ShiftInst, Inst1st.getOperand(i));
-                        AddInst->insertAfter(ShiftInst);
-			Inst1st.replaceAllUsesWith(AddInst);
+		    // x*C = (x << val) -/+ x, ripetuto tante volte quanto dista C da 2^val
+		    int64_t dist = C->getValue().getSExtValue() - (int64_t(1) << val);
+		    if (dist != 0) {
+                        Instruction *Last = ShiftInst;
+                        for (int64_t k = 0; k < std::abs(dist); ++k) {
+                            Instruction *AddSubInst = BinaryOperator::Create(dist < 0 ? Instruction::Sub : Instruction::Add, Last, Inst1st.getOperand(i));
+                            AddSubInst->insertAfter(Last);
+                            Last = AddSubInst;
+                        }
+			Inst1st.replaceAllUsesWith(Last);
+			++NumMulToShiftAddSub;
                     } 
-		    else
+		    else {
 			    Inst1st.replaceAllUsesWith(ShiftInst);
+			    ++NumMulToShift;
+		    }
+		    Changed = true;
+		    LLVM_DEBUG(dbgs() << "localopts: strength reduction " << Inst1st << "\n");
             }}
             else
-                if(C->getValue().isPowerOf2()){
+                if(Opts.DivToShift && C->getValue().isPowerOf2()){
                     auto val = C->getValue().exactLogBase2();
-                    APInt app(32, val);
-                    ConstantInt *CC = ConstantInt::get(Inst1st.getOperand(i)->getType()->getContext(), app);
+                    Constant *CC = ConstantInt::get(Inst1st.getOperand(i)->getType(), val);
                     ShiftInst = BinaryOperator::Create(Instruction::AShr, Inst1st.getOperand(i), CC);
             	    ShiftInst->insertAfter(&Inst1st);
             	    Inst1st.replaceAllUsesWith(ShiftInst);
+            	    ++NumDivToShift;
+            	    Changed = true;
+            	    LLVM_DEBUG(dbgs() << "localopts: strength reduction " << Inst1st << "\n");
             }}
         i--;
   }
+  return Changed;
 }
 
-bool runOnBasicBlock(BasicBlock &B) {
-    multiInstructionOptimization(*B);
+bool runOnBasicBlock(BasicBlock &B, const LocalOptsOptions &Opts) {
+    bool Changed = false;
+    if (Opts.MultiInstruction)
+      Changed |= multiInstructionOptimization(B);
     for(auto &Inst1st : B){ 
         //prima di tutto cerco di ottimizzare una Algebraic Identity
         if(Inst1st.getOpcode() == Instruction::Add)
-          algebraicIdentity(Inst1st, true);
+          Changed |= algebraicIdentity(Inst1st, true);
         else if(Inst1st.getOpcode() == Instruction::Mul){
-          if(!algebraicIdentity(Inst1st, false)) //se eseguo la algebraic identity non faccio la strength reduction
-              strengthReduction(Inst1st, true);
+          if(algebraicIdentity(Inst1st, false)) //se eseguo la algebraic identity non faccio la strength reduction
+              Changed = true;
+          else
+              Changed |= strengthReduction(Inst1st, true, Opts);
         }
         else if(Inst1st.getOpcode() == Instruction::SDiv)
-          strengthReduction(Inst1st, false);
+          Changed |= strengthReduction(Inst1st, false, Opts);
         
     }
-    return true;
+    return Changed;
 }
 
 
-bool runOnFunction(Function &F) {
+bool runOnFunction(Function &F, const LocalOptsOptions &Opts) {
   bool Transformed = false;
 
   for (auto Iter = F.begin(); Iter != F.end(); ++Iter) {
-    if (runOnBasicBlock(*Iter)) {
+    if (runOnBasicBlock(*Iter, Opts)) {
       Transformed = true;
     }
   }
@@ -149,28 +183,77 @@ bool runOnFunction(Function &F) {
 
 PreservedAnalyses LocalOpts::run(Module &M,
                                       ModuleAnalysisManager &AM) {
-  for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter)
-    if (runOnFunction(*Fiter))
-      return PreservedAnalyses::none();
+  // ogni funzione passa dalla cache per conto suo, quindi le visitiamo tutte
+  // invece di fermarci alla prima trasformata
+  bool Transformed = false;
+  for (auto Fiter = M.begin(); Fiter != M.end(); ++Fiter) {
+    if (Fiter->isDeclaration())
+      continue;
+    // LocalOpts e' un pass di modulo: -time-passes lo misura tutto insieme,
+    // in -time-trace separiamo le funzioni
+    TimeTraceScope TimeScope("LocalOpts", Fiter->getName());
+    CachedFunction Cache(*Fiter, "localopts;near-pow2-dist=" + Twine(Opts.NearPow2Dist) +
+                                     ";div=" + Twine(Opts.DivToShift) +
+                                     ";multi-inst=" + Twine(Opts.MultiInstruction));
+    if (Cache.isHit()) {
+      Transformed |= !Cache.getHitResult().areAllPreserved();
+      continue;
+    }
+    bool Changed = runOnFunction(*Fiter, Opts);
+    Cache.store(Changed);
+    Transformed |= Changed;
+  }
 
+  if (Transformed)
+    return PreservedAnalyses::none();
   return PreservedAnalyses::all();
 }
 
 
 
 
-int is_Near_Power_Of_Two(int num) {
+int is_Near_Power_Of_Two(int num, unsigned maxDist) {
 //Con un numero negativo o nullo non è possibile fare nulla
     if (num <= 0) {
         return -1;
     } 
-    double log2num = log2(num); //logaritmo del numero
-    int nearestPower = round(log2num); //intero più vicino, ossia l'esponente più vicino
-    int nearestPowerValue = pow(2, nearestPower); //valore della potenza più vicina
+    // le due potenze fra cui cade il numero: la piu' vicina va scelta per
+    // distanza, arrotondare log2(num) sceglierebbe 32 invece di 16 per 23
+    int lowerPower = floor(log2(num));
+    int64_t lowerDist = num - (int64_t(1) << lowerPower);
+    int64_t upperDist = (int64_t(1) << (lowerPower + 1)) - num;
+    // a parita' si sceglie la potenza sopra, che si sottrae (x*3 = (x<<2)-x)
+    int nearestPower = lowerDist < upperDist ? lowerPower : lowerPower + 1; //esponente più vicino
+    int64_t nearestDist = std::min(lowerDist, upperDist);
 
-    if (abs(nearestPowerValue - num) <= 1) { //controllo che sia effettivamente "vicino"
+    if (nearestDist <= int64_t(maxDist)) { //controllo che sia effettivamente "vicino"
         return nearestPower;
     } else {
         return -1;
     }
 }
+
+Expected<LocalOptsOptions> llvm::parseLocalOptsOptions(StringRef Params) {
+  LocalOptsOptions Opts;
+  while (!Params.empty()) {
+    StringRef ParamName;
+    std::tie(ParamName, Params) = Params.split(';');
+    StringRef Value = ParamName;
+    if (ParamName == "div" || ParamName == "no-div") {
+      Opts.DivToShift = ParamName == "div";
+    } else if (ParamName == "multi-inst" || ParamName == "no-multi-inst") {
+      Opts.MultiInstruction = ParamName == "multi-inst";
+    } else if (Value.consume_front("near-pow2-dist=")) {
+      // ogni unita' di distanza costa una add/sub: oltre 16 la mul conviene sempre
+      if (Value.getAsInteger(0, Opts.NearPow2Dist) || Opts.NearPow2Dist > 16)
+        return make_error<StringError>(
+            formatv("localopts: near-pow2-dist vuole un intero fra 0 e 16: '{0}'", ParamName).str(),
+            inconvertibleErrorCode());
+    } else {
+      return make_error<StringError>(
+          formatv("localopts: parametro sconosciuto '{0}'", ParamName).str(),
+          inconvertibleErrorCode());
+    }
+  }
+  return Opts;
+}
@@ -4,11 +4,29 @@
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/Support/Alignment.h"
+#include "llvm/Support/Error.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/Analysis/ValueTracking.h"
 namespace llvm {
+	// Opzioni di localopts<...> (vedi parseLocalOptsOptions)
+	struct LocalOptsOptions {
+		// x*C diventa (x << k) +/- x ripetuto |C - 2^k| volte, se non supera questa distanza
+		unsigned NearPow2Dist = 1;
+		// x/2^k diventa x >> k
+		bool DivToShift = true;
+		// elimina le coppie add/sub con la stessa costante
+		bool MultiInstruction = true;
+	};
+
 	class LocalOpts : public PassInfoMixin<LocalOpts> {
-		public : PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+		public :
+			LocalOpts(LocalOptsOptions Opts = LocalOptsOptions()) : Opts(Opts) {}
+			PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+		private :
+			LocalOptsOptions Opts;
 	};
+
+	// "near-pow2-dist=N;div;no-div;multi-inst;no-multi-inst", per PassRegistry.def
+	Expected<LocalOptsOptions> parseLocalOptsOptions(StringRef Params);
 }
 #endif 
@@ -0,0 +1,297 @@
+//===-- LoopFission.cpp - Distribuzione dei loop ---------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Ogni store del loop e' uno "statement": insieme ai load da cui dipende il
+// suo valore forma una partizione. Con DependenceAnalysis si costruisce il
+// grafo delle dipendenze fra partizioni; le partizioni su uno stesso ciclo
+// restano nello stesso loop, le altre finiscono in loop separati (ordinati
+// topologicamente), che il vettorizzatore o loop-idiom possono poi gestire.
+//
+//===----------------------------------------------------------------------===//
+#include "llvm/Transforms/Utils/LoopFission.h"
+#include "llvm/Transforms/Utils/PassCache.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/LoopIterator.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/Local.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "loopfission"
+
+STATISTIC(NumDistributed, "Loop divisi");
+STATISTIC(NumPartitions, "Loop prodotti dalla divisione");
+
+// Una partizione: gli store che finiranno nello stesso loop e gli accessi in
+// memoria che restano in quel loop dopo aver tolto gli store degli altri
+struct Partition {
+  SmallVector<StoreInst *, 4> Stores;
+  SmallVector<Instruction *, 8> MemInsts;
+  unsigned FirstPos; // posizione del primo store nell'ordine del programma
+};
+
+// Il loop deve avere un'unica uscita, nessuna chiamata e nessun valore usato
+// fuori dal loop: cosi' ogni copia puo' essere eseguita per intero prima della
+// successiva
+static bool isDistributable(Loop *L) {
+  if (!L->isInnermost() || !L->getLoopPreheader() || !L->getExitingBlock() ||
+      !L->getExitBlock() || !L->hasDedicatedExits())
+    return false;
+  for (auto *BB : L->blocks()) {
+    for (auto &I : *BB) {
+      if (I.mayReadOrWriteMemory()) {
+        if (auto *LD = dyn_cast<LoadInst>(&I)) {
+          if (!LD->isSimple()) return false;
+        } else if (auto *ST = dyn_cast<StoreInst>(&I)) {
+          if (!ST->isSimple()) return false;
+        } else
+          return false;
+      }
+      for (User *U : I.users())
+        if (!L->contains(cast<Instruction>(U)))
+          return false;
+    }
+  }
+  return true;
+}
+
+// Aggiunge a Slice i load del loop da cui dipende V (risalendo gli operandi)
+static void collectLoadSlice(Value *V, Loop *L, SmallPtrSetImpl<Instruction *> &Visited,
+                             SmallVectorImpl<Instruction *> &Slice) {
+  auto *I = dyn_cast<Instruction>(V);
+  if (!I || !L->contains(I) || !Visited.insert(I).second)
+    return;
+  if (isa<LoadInst>(I))
+    Slice.push_back(I);
+  for (Value *Op : I->operands())
+    collectLoadSlice(Op, L, Visited, Slice);
+}
+
+// Dipendenza fra A e B, con A che precede B nel programma. Forward: va da A
+// a B nella stessa iterazione o in una successiva, quindi A deve restare
+// prima di B. Backward: va da B a un'iterazione successiva di A, quindi B
+// deve stare prima di A. Se la direzione non e' nota valgono entrambe.
+static void getDependence(Instruction *A, Instruction *B, unsigned Level, DependenceInfo &DI,
+                          bool &Forward, bool &Backward) {
+  Forward = Backward = false;
+  if (isa<LoadInst>(A) && isa<LoadInst>(B))
+    return;
+  auto Dep = DI.depends(A, B, true);
+  if (!Dep)
+    return;
+  if (Dep->isConfused() || Dep->getLevels() < Level) {
+    Forward = Backward = true;
+    return;
+  }
+  unsigned Dir = Dep->getDirection(Level);
+  Forward = Dir & (Dependence::DVEntry::LT | Dependence::DVEntry::EQ);
+  Backward = Dir & Dependence::DVEntry::GT;
+}
+
+// Costruisce le partizioni e le ordina; restituisce false se il loop non si
+// puo' dividere (una sola partizione dopo aver fuso i cicli)
+static bool buildPartitions(Loop *L, LoopInfo &LI, DependenceInfo &DI, SmallVectorImpl<Partition> &Result) {
+  // posizione di ogni istruzione nell'ordine del programma (RPO del corpo)
+  DenseMap<Instruction *, unsigned> Pos;
+  SmallVector<StoreInst *, 8> Stores;
+  SmallVector<Instruction *, 8> ControlLoads; // load che decidono i branch: restano in ogni copia
+  LoopBlocksRPO RPOT(L);
+  RPOT.perform(&LI);
+  unsigned Next = 0;
+  for (BasicBlock *BB : RPOT) {
+    for (auto &I : *BB) {
+      Pos[&I] = Next++;
+      if (auto *SI = dyn_cast<StoreInst>(&I))
+        Stores.push_back(SI);
+    }
+    SmallPtrSet<Instruction *, 8> Visited;
+    for (Value *Op : BB->getTerminator()->operands())
+      collectLoadSlice(Op, L, Visited, ControlLoads);
+  }
+  unsigned N = Stores.size();
+  if (N < 2)
+    return false;
+
+  SmallVector<Partition, 8> Parts(N);
+  for (unsigned i = 0; i < N; ++i) {
+    SmallPtrSet<Instruction *, 8> Visited;
+    Parts[i].Stores.push_back(Stores[i]);
+    Parts[i].MemInsts.push_back(Stores[i]);
+    for (Value *Op : Stores[i]->operands())
+      collectLoadSlice(Op, L, Visited, Parts[i].MemInsts);
+    for (Instruction *CL : ControlLoads)
+      if (Visited.insert(CL).second)
+        Parts[i].MemInsts.push_back(CL);
+    Parts[i].FirstPos = Pos[Stores[i]];
+  }
+
+  // Reach[p][q]: la partizione p deve essere eseguita prima di q
+  SmallVector<SmallVector<bool, 8>, 8> Reach(N, SmallVector<bool, 8>(N, false));
+  unsigned Level = L->getLoopDepth();
+  for (unsigned p = 0; p < N; ++p) {
+    for (unsigned q = p + 1; q < N; ++q) {
+      for (Instruction *A : Parts[p].MemInsts) {
+        for (Instruction *B : Parts[q].MemInsts) {
+          if (A == B)
+            continue;
+          Instruction *First = Pos[A] < Pos[B] ? A : B;
+          Instruction *Second = First == A ? B : A;
+          bool Forward, Backward;
+          getDependence(First, Second, Level, DI, Forward, Backward);
+          unsigned FirstPart = First == A ? p : q;
+          unsigned SecondPart = First == A ? q : p;
+          if (Forward)
+            Reach[FirstPart][SecondPart] = true;
+          if (Backward)
+            Reach[SecondPart][FirstPart] = true;
+        }
+      }
+    }
+  }
+  // chiusura transitiva: due partizioni sono nello stesso ciclo se si raggiungono a vicenda
+  for (unsigned k = 0; k < N; ++k)
+    for (unsigned i = 0; i < N; ++i)
+      if (Reach[i][k])
+        for (unsigned j = 0; j < N; ++j)
+          if (Reach[k][j])
+            Reach[i][j] = true;
+
+  SmallVector<int, 8> Component(N, -1);
+  SmallVector<Partition, 8> Merged;
+  for (unsigned i = 0; i < N; ++i) {
+    if (Component[i] != -1)
+      continue;
+    Component[i] = Merged.size();
+    Merged.push_back(Parts[i]);
+    for (unsigned j = i + 1; j < N; ++j) {
+      if (Reach[i][j] && Reach[j][i]) {
+        Component[j] = Component[i];
+        Partition &M = Merged.back();
+        M.Stores.append(Parts[j].Stores.begin(), Parts[j].Stores.end());
+        M.MemInsts.append(Parts[j].MemInsts.begin(), Parts[j].MemInsts.end());
+      }
+    }
+  }
+  if (Merged.size() < 2)
+    return false;
+
+  // ordinamento topologico dei componenti; a parita' vince l'ordine del programma
+  SmallVector<bool, 8> Emitted(Merged.size(), false);
+  for (unsigned Round = 0; Round < Merged.size(); ++Round) {
+    int Best = -1;
+    for (unsigned c = 0; c < Merged.size(); ++c) {
+      if (Emitted[c])
+        continue;
+      bool Ready = true;
+      for (unsigned i = 0; i < N && Ready; ++i)
+        for (unsigned j = 0; j < N && Ready; ++j)
+          if ((unsigned)Component[j] == c && Component[i] != Component[j] &&
+              !Emitted[Component[i]] && Reach[i][j])
+            Ready = false;
+      if (Ready && (Best == -1 || Merged[c].FirstPos < Merged[Best].FirstPos))
+        Best = c;
+    }
+    Emitted[Best] = true;
+    Result.push_back(Merged[Best]);
+  }
+  return true;
+}
+
+// Toglie da una copia del loop gli store che non le appartengono, poi
+// elimina i calcoli rimasti senza usi
+static void removeForeignStores(ArrayRef<StoreInst *> Foreign) {
+  for (StoreInst *SI : Foreign) {
+    // valore e indirizzo possono avere calcoli in comune: cancellando l'uno
+    // si puo' cancellare anche l'altro, quindi li seguiamo con dei handle
+    SmallVector<WeakTrackingVH, 2> Ops(SI->op_begin(), SI->op_end());
+    SI->eraseFromParent();
+    RecursivelyDeleteTriviallyDeadInstructionsPermissive(Ops);
+  }
+}
+
+// Stessa strategia di LoopDistribute: ogni partizione tranne l'ultima viene
+// eseguita in una copia del loop inserita prima dell'originale
+static void distributeLoop(Loop *L, ArrayRef<Partition> Parts, LoopInfo &LI, DominatorTree &DT) {
+  BasicBlock *PH = L->getLoopPreheader();
+  // il preheader clonato deve contenere solo il salto all'header
+  if (!PH->getSinglePredecessor() || &*PH->begin() != PH->getTerminator())
+    SplitBlock(PH, PH->getTerminator(), &DT, &LI);
+  BasicBlock *OrigPH = L->getLoopPreheader();
+  BasicBlock *Pred = OrigPH->getSinglePredecessor();
+  BasicBlock *ExitBlock = L->getExitBlock();
+
+  SmallVector<Loop *, 4> Loops(Parts.size(), nullptr);
+  std::vector<ValueToValueMapTy> VMaps(Parts.size());
+  Loops.back() = L;
+  BasicBlock *TopPH = OrigPH;
+  for (int Idx = Parts.size() - 2; Idx >= 0; --Idx) {
+    SmallVector<BasicBlock *, 8> Blocks;
+    Loop *NewLoop = cloneLoopWithPreheader(TopPH, Pred, L, VMaps[Idx], ".fiss" + Twine(Idx), &LI, &DT, Blocks);
+    VMaps[Idx][ExitBlock] = TopPH; // la copia continua nel loop successivo
+    remapInstructionsInBlocks(Blocks, VMaps[Idx]);
+    Loops[Idx] = NewLoop;
+    TopPH = NewLoop->getLoopPreheader();
+  }
+  Pred->getTerminator()->replaceUsesOfWith(OrigPH, TopPH);
+  for (unsigned Idx = 1; Idx < Parts.size(); ++Idx)
+    DT.changeImmediateDominator(Loops[Idx]->getLoopPreheader(), Loops[Idx - 1]->getExitingBlock());
+
+  // in ogni copia restano solo gli store della sua partizione
+  for (unsigned Idx = 0; Idx < Parts.size(); ++Idx) {
+    SmallVector<StoreInst *, 8> Foreign;
+    for (unsigned Other = 0; Other < Parts.size(); ++Other) {
+      if (Other == Idx)
+        continue;
+      for (StoreInst *SI : Parts[Other].Stores)
+        Foreign.push_back(Idx + 1 == Parts.size() ? SI : cast<StoreInst>(VMaps[Idx][SI]));
+    }
+    removeForeignStores(Foreign);
+  }
+}
+
+PreservedAnalyses LoopFission::run(Function &F, FunctionAnalysisManager &FAM) {
+  CachedFunction Cache(F, "loopfission");
+  if (Cache.isHit())
+    return Cache.getHitResult();
+  LoopInfo &LI = FAM.getResult<LoopAnalysis>(F);
+  DominatorTree &DT = FAM.getResult<DominatorTreeAnalysis>(F);
+  ScalarEvolution &SE = FAM.getResult<ScalarEvolutionAnalysis>(F);
+  DependenceInfo &DI = FAM.getResult<DependenceAnalysis>(F);
+
+  // le partizioni si calcolano tutte prima di toccare il CFG
+  SmallVector<std::pair<Loop *, SmallVector<Partition, 8>>, 4> Work;
+  for (Loop *L : LI.getLoopsInPreorder()) {
+    if (!isDistributable(L))
+      continue;
+    SmallVector<Partition, 8> Parts;
+    if (buildPartitions(L, LI, DI, Parts))
+      Work.push_back({L, Parts});
+  }
+  if (Work.empty())
+    return Cache.store(PreservedAnalyses::all());
+
+  for (auto &W : Work) {
+    LLVM_DEBUG(dbgs() << "loopfission: " << W.first->getName() << " diviso in "
+                      << W.second.size() << " loop\n");
+    SE.forgetLoop(W.first);
+    distributeLoop(W.first, W.second, LI, DT);
+    ++NumDistributed;
+    NumPartitions += W.second.size();
+  }
+
+  PreservedAnalyses PA;
+  PA.preserve<LoopAnalysis>();
+  PA.preserve<DominatorTreeAnalysis>();
+  return Cache.store(PA);
+}
@@ -0,0 +1,17 @@
+#ifndef LLVM_TRANSFORMS_LOOPFISSION_H
+#define LLVM_TRANSFORMS_LOOPFISSION_H
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/DependenceAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+
+namespace llvm {
+    // Trasformazione opposta a LoopFussion: divide un loop in piu' loop, uno
+    // per ogni gruppo di store legati da un ciclo di dipendenze
+    class LoopFission : public PassInfoMixin<LoopFission> {
+          public : PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM);
+    };
+}
+#endif
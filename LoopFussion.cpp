@@ -1,17 +1,59 @@
 #include "llvm/Transforms/Utils/LoopFussion.h"
+#include "llvm/Transforms/Utils/PassCache.h"
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/IR/Dominators.h>
 #include <llvm/ADT/DepthFirstIterator.h>
 #include "llvm/Analysis/LoopAnalysisManager.h"
 #include "llvm/Transforms/Scalar/LoopPassManager.h"
+#include "llvm/Analysis/VectorUtils.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
+#include <llvm/ADT/SetVector.h>
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/TimeProfiler.h"
 using namespace llvm;
 
+#define DEBUG_TYPE "loopfusion"
+
+STATISTIC(NumCandidates, "Coppie di loop consecutive esaminate");
+STATISTIC(NumFused, "Coppie di loop fuse");
+STATISTIC(NumVersioned, "Coppie fuse dietro controlli di alias a runtime");
+STATISTIC(NumRuntimeChecks, "Controlli di alias a runtime inseriti");
+STATISTIC(NumAnnotatedParallel, "Loop marcati come paralleli per il vettorizzatore");
+STATISTIC(NumUnsupportedShape, "Coppie rifiutate: forma dei loop non supportata da fuseLoops");
+STATISTIC(NumNotAdjacent, "Coppie rifiutate: loop non adiacenti");
+STATISTIC(NumTripCountMismatch, "Coppie rifiutate: numero di iterazioni diverso");
+STATISTIC(NumNotControlFlowEquivalent, "Coppie rifiutate: loop non control flow equivalent");
+STATISTIC(NumNegativeDistance, "Coppie rifiutate: dipendenze a distanza negativa");
+STATISTIC(NumLiveOut, "Coppie rifiutate: valori dei loop usati dopo il secondo");
+STATISTIC(NumAliasUnchecked, "Coppie rifiutate: alias non verificabili a runtime");
+STATISTIC(NumChainTooLong, "Coppie rifiutate: catena di loop fusi oltre max-chain");
+
+// Intervallo di byte [Low, High) toccato da un puntatore base dentro un loop
+struct PointerRange {
+    const SCEV *Low;
+    const SCEV *High;
+};
+
+// I due intervalli non devono sovrapporsi perche' il loop fuso sia corretto
+struct RuntimeCheck {
+    PointerRange J;
+    PointerRange K;
+};
+
 bool areAdjacent(Loop *Lj, Loop *Lk) {
         SmallVector<BasicBlock *, 4> ExitJ;
         Lj->getUniqueNonLatchExitBlocks(ExitJ); // ottengo i blocchi d'uscita non successori del latch
         for(auto *BB : ExitJ) {
           if(Lk->isGuarded() and BB != dyn_cast<BasicBlock>(Lk->getLoopGuardBranch())){
-            outs() << "loop guarded\n";
+            LLVM_DEBUG(dbgs() << "loop guarded\n");
             return false;
           }
           if(!Lk->isGuarded() and Lk->contains(BB)) return false;
@@ -24,16 +66,16 @@ bool areControlFlowEquivalent(Loop *Lj, Loop *Lk, DominatorTree &DT, PostDominat
     SmallVector<BasicBlock *, 4> ExitJ;
     Lj->getExitingBlocks(ExitJ); //prendo i blocchi nel loop che hanno successori al di fuori
     for(auto *BB : ExitJ){
-        if(BB->getTerminator()->getNumSuccessors()==0) outs() << "niente successori\n";
+        if(BB->getTerminator()->getNumSuccessors()==0) LLVM_DEBUG(dbgs() << "niente successori\n");
         else {
           BasicBlock *nextb = BB->getTerminator()->getSuccessor(0);
           //controllo se il successore è al di fuori del loop
           if(!Lj->contains(nextb)){
-              if(!DT.dominates(BB, nextb)) outs() << "non domina\n";
-              if(!PDT.dominates(nextb, BB)) outs() << "non domina\n";
+              if(!DT.dominates(BB, nextb)) LLVM_DEBUG(dbgs() << "non domina\n");
+              if(!PDT.dominates(nextb, BB)) LLVM_DEBUG(dbgs() << "non domina\n");
               if(!DT.dominates(BB, nextb) || !PDT.dominates(nextb, BB)) return false;
           }
-          else outs() << "blocco nel loop 1\n";
+          else LLVM_DEBUG(dbgs() << "blocco nel loop 1\n");
         }
     }
     
@@ -49,7 +91,7 @@ bool haveSameIterationCount(Loop *Lj, Loop *Lk, ScalarEvolution &SE) {
 
     // Controllo che i metodi precedenti non abbiano ritornato SCEVCouldNotCompute
     if (isa<SCEVCouldNotCompute>(TripCountJ) || isa<SCEVCouldNotCompute>(TripCountK)) {
-        outs() << "SCEVCould not compute\n";
+        LLVM_DEBUG(dbgs() << "SCEVCould not compute\n");
         return false;
     }
     //estraggo i valori
@@ -59,29 +101,72 @@ bool haveSameIterationCount(Loop *Lj, Loop *Lk, ScalarEvolution &SE) {
     return ValueJ == ValueK;
   }
 
-bool hasNegativeDistanceDependencies(Loop *Lj, Loop *Lk, DependenceInfo &DA) {
+// DA confronta gli accessi solo ai livelli dei loop che li contengono
+// entrambi: Lj e Lk sono fratelli, quindi la distanza al livello che la
+// fusione crea va calcolata a parte. Con IJ = {BaseJ,+,Step}<Lj> e
+// IK = {BaseK,+,Step}<Lk>, IK all'iterazione i' tocca quello che IJ tocca
+// all'iterazione i se Step * (i' - i) = BaseJ - BaseK: la distanza e' >= 0
+// se BaseJ - BaseK ha il segno di Step e nessuno dei due accessi e' piu'
+// largo del passo (altrimenti si sovrapporrebbero anche a distanza -1).
+// Restituisce true solo se lo dimostra.
+bool hasNonNegativeFusedDistance(Instruction *IJ, Loop *Lj, Instruction *IK, Loop *Lk, ScalarEvolution &SE) {
+    Value *PtrJ = getLoadStorePointerOperand(IJ);
+    Value *PtrK = getLoadStorePointerOperand(IK);
+    if (!PtrJ || !PtrK) return false;
+    auto *ARJ = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(PtrJ));
+    auto *ARK = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(PtrK));
+    if (!ARJ || !ARK || ARJ->getLoop() != Lj || ARK->getLoop() != Lk || !ARJ->isAffine() || !ARK->isAffine())
+        return false;
+    auto *StepJ = dyn_cast<SCEVConstant>(ARJ->getStepRecurrence(SE));
+    auto *StepK = dyn_cast<SCEVConstant>(ARK->getStepRecurrence(SE));
+    if (!StepJ || StepJ != StepK || StepJ->getAPInt().isZero()) return false;
+    auto *Diff = dyn_cast<SCEVConstant>(SE.getMinusSCEV(ARJ->getStart(), ARK->getStart()));
+    if (!Diff) return false;
+
+    const DataLayout &DL = IJ->getModule()->getDataLayout();
+    uint64_t Step = StepJ->getAPInt().abs().getZExtValue();
+    if (DL.getTypeStoreSize(getLoadStoreType(IJ)).getFixedSize() > Step ||
+        DL.getTypeStoreSize(getLoadStoreType(IK)).getFixedSize() > Step)
+        return false;
+    const APInt &D = Diff->getAPInt();
+    return D.isZero() || D.isNegative() == StepJ->getAPInt().isNegative();
+}
+
+bool hasNegativeDistanceDependencies(Loop *Lj, Loop *Lk, DependenceInfo &DA, ScalarEvolution &SE) {
     // Itera attraverso tutte le istruzioni in Lj
     for (auto *BBJ : Lj->blocks()) {
         for (auto &IJ : *BBJ) {
+            if (!IJ.mayReadOrWriteMemory()) continue;
             // Itera attraverso tutte le istruzioni in Lk
             for (auto *BBK : Lk->blocks()) {
                 for (auto &IK : *BBK) {
+                    if (!IK.mayReadOrWriteMemory()) continue;
+                    // due letture non creano dipendenze
+                    if (!IJ.mayWriteToMemory() && !IK.mayWriteToMemory()) continue;
                     // Ottieni la dipendenza tra IJ e IK
                     if (auto Dep = DA.depends(&IJ, &IK, true)) { 
                         //ritorna null se non c'è dipendenza, quindi continuo con il ciclo
+                        // le dipendenze "confused" fra basi diverse le coprono i
+                        // controlli a runtime (collectRuntimeChecks)
+                        if (Dep->isConfused()) continue;
                         // ora verifichiamo se c'è una distanza negativa
                         for (unsigned Level = 1; Level <= Dep->getLevels(); ++Level) { //itero su tutti i livelli di dipendenza (ossia attraverso le varie ipotetiche nidificazioni)
                             const SCEV *Distance = Dep->getDistance(Level);
-                            if(isa<SCEVConstant>(Distance)){
+                            if(isa_and_nonnull<SCEVConstant>(Distance)){
                                 const APInt &DistanceValue = dyn_cast<SCEVConstant>(Distance)->getAPInt();
                                 if (DistanceValue.isNegative()) {//ottengo la distanza tra le due istruzioni
                                                                   // ossia quante iterazioni separano l'uso di una variabile nel secondo loop dalla definizione di quella variabile nel primo loop
-                                    outs()<<"Distanza a negativa trovata\n";
+                                    LLVM_DEBUG(dbgs() << "Distanza a negativa trovata\n");
                                     return true; // se è negativa ritorno true
                                 }
                             
                             }
                         }
+                        // il livello del loop fuso non e' fra quelli di DA
+                        if (!hasNonNegativeFusedDistance(&IJ, Lj, &IK, Lk, SE)) {
+                            LLVM_DEBUG(dbgs() << "distanza nel loop fuso non dimostrabile >= 0\n");
+                            return true;
+                        }
                     }
                 }
             }
@@ -90,44 +175,226 @@ bool hasNegativeDistanceDependencies(Loop *Lj, Loop *Lk, DependenceInfo &DA) {
     return false; // Nessuna dipendenza a distanza negativa trovata
 }
 
-bool canFuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, DominatorTree &DT, PostDominatorTree &PDT, ScalarEvolution &SE, DependenceInfo &DI) {
+// Calcola l'intervallo toccato dall'accesso I durante tutto il loop L, come
+// interi (ptrtoint) per poterli confrontare nel blocco dei controlli
+bool getAccessRange(Instruction *I, Loop *L, ScalarEvolution &SE, PointerRange &Range) {
+    Value *Ptr = getLoadStorePointerOperand(I);
+    if (!Ptr) return false;
+    const DataLayout &DL = I->getModule()->getDataLayout();
+    Type *IntPtrTy = DL.getIntPtrType(Ptr->getType());
+    const SCEV *Size = SE.getConstant(IntPtrTy, DL.getTypeStoreSize(getLoadStoreType(I)).getFixedSize());
+
+    const SCEV *Low, *High;
+    const SCEV *S = SE.getSCEV(Ptr);
+    if (SE.isLoopInvariant(S, L)) {
+        Low = High = S;
+    }
+    else {
+        auto *AR = dyn_cast<SCEVAddRecExpr>(S);
+        if (!AR || AR->getLoop() != L || !AR->isAffine()) return false;
+        auto *Step = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE));
+        const SCEV *BTC = SE.getBackedgeTakenCount(L);
+        if (!Step || isa<SCEVCouldNotCompute>(BTC)) return false;
+        // con un loop che esce dall'header l'ultimo valore non viene usato:
+        // l'intervallo e' un po' piu' largo del necessario, ma resta corretto
+        const SCEV *Last = AR->evaluateAtIteration(BTC, SE);
+        Low = Step->getAPInt().isNegative() ? Last : AR->getStart();
+        High = Step->getAPInt().isNegative() ? AR->getStart() : Last;
+    }
+    Low = SE.getPtrToIntExpr(Low, IntPtrTy);
+    High = SE.getPtrToIntExpr(High, IntPtrTy);
+    if (isa<SCEVCouldNotCompute>(Low) || isa<SCEVCouldNotCompute>(High)) return false;
+    Range.Low = Low;
+    Range.High = SE.getAddExpr(High, Size);
+    return true;
+}
+
+// Unione degli intervalli di tutti gli accessi di L che partono da Base
+bool getBaseRange(Loop *L, const SCEV *Base, ScalarEvolution &SE, PointerRange &Range) {
+    bool Found = false;
+    for (auto *BB : L->blocks()) {
+        for (auto &I : *BB) {
+            Value *Ptr = getLoadStorePointerOperand(&I);
+            if (!Ptr || SE.getPointerBase(SE.getSCEV(Ptr)) != Base) continue;
+            PointerRange R;
+            if (!getAccessRange(&I, L, SE, R)) return false;
+            if (!Found) Range = R;
+            else {
+                Range.Low = SE.getUMinExpr(Range.Low, R.Low);
+                Range.High = SE.getUMaxExpr(Range.High, R.High);
+            }
+            Found = true;
+        }
+    }
+    return Found;
+}
+
+// Blocchi fra il preheader di Lj e l'uscita di Lk: sono quelli che vengono
+// duplicati per la versione non fusa
+void getVersionedRegion(Loop *Lj, Loop *Lk, SmallVectorImpl<BasicBlock *> &Region) {
+    Region.append(Lj->block_begin(), Lj->block_end());
+    Region.push_back(Lk->getLoopPreheader());
+    Region.append(Lk->block_begin(), Lk->block_end());
+}
+
+// fuseLoops fa uscire il loop fuso dall'header di Lj direttamente
+// nell'uscita di Lk, lasciando irraggiungibili il preheader e l'header di
+// Lk: un valore calcolato nei loop e usato dopo, o una PHI nell'uscita di Lk,
+// non avrebbero piu' una definizione o un predecessore validi. Gli usi nei
+// blocchi irraggiungibili (header e latch di un Lk gia' fuso) non contano.
+bool hasLiveOuts(Loop *Lj, Loop *Lk, DominatorTree &DT) {
+    BasicBlock *Exit = Lk->getExitBlock();
+    if (!Exit || !Exit->phis().empty()) return true;
+    for (Loop *L : {Lj, Lk})
+        for (auto *BB : L->blocks())
+            for (auto &I : *BB)
+                for (User *U : I.users()) {
+                    BasicBlock *UseBB = cast<Instruction>(U)->getParent();
+                    if (!Lj->contains(UseBB) && !Lk->contains(UseBB) && UseBB != Lk->getLoopPreheader() &&
+                        DT.isReachableFromEntry(UseBB))
+                        return true;
+                }
+    return false;
+}
+
+// Il versioning richiede che fra i due loop ci sia solo il preheader di Lk
+// (i valori usati dopo i loop li ha gia' esclusi hasLiveOuts)
+bool canVersionLoops(Loop *Lj, Loop *Lk) {
+    if (!Lj->getLoopPreheader() || !Lk->getLoopPreheader()) return false;
+    if (Lj->getExitBlock() != Lk->getLoopPreheader()) return false;
+    return Lk->getLoopPreheader()->getSinglePredecessor() != nullptr;
+}
+
+// Raccoglie i controlli a runtime per le coppie di accessi che DA non sa
+// separare (dipendenza "confused", tipicamente puntatori passati come
+// argomento che potrebbero essere in alias). Restituisce false se una coppia
+// non e' controllabile o se i controlli sono troppi.
+bool collectRuntimeChecks(Loop *Lj, Loop *Lk, DependenceInfo &DI, ScalarEvolution &SE, const LoopFusionOptions &Opts, SmallVectorImpl<RuntimeCheck> &Checks) {
+    SmallSetVector<std::pair<const SCEV *, const SCEV *>, 8> BasePairs;
+    for (auto *BBJ : Lj->blocks()) {
+        for (auto &IJ : *BBJ) {
+            if (!IJ.mayReadOrWriteMemory()) continue;
+            for (auto *BBK : Lk->blocks()) {
+                for (auto &IK : *BBK) {
+                    if (!IK.mayReadOrWriteMemory()) continue;
+                    if (!IJ.mayWriteToMemory() && !IK.mayWriteToMemory()) continue;
+                    auto Dep = DI.depends(&IJ, &IK, true);
+                    if (!Dep || !Dep->isConfused()) continue;
+                    Value *PtrJ = getLoadStorePointerOperand(&IJ);
+                    Value *PtrK = getLoadStorePointerOperand(&IK);
+                    if (!PtrJ || !PtrK) return false; // chiamate
+                    const SCEV *BaseJ = SE.getPointerBase(SE.getSCEV(PtrJ));
+                    const SCEV *BaseK = SE.getPointerBase(SE.getSCEV(PtrK));
+                    // stessa base: gli intervalli si sovrapporrebbero sempre
+                    if (BaseJ == BaseK) return false;
+                    BasePairs.insert({BaseJ, BaseK});
+                }
+            }
+        }
+    }
+    if (BasePairs.empty()) return true;
+    if (!Opts.AllowGuarded) {
+        LLVM_DEBUG(dbgs() << "servono controlli a runtime (no-allow-guarded)\n");
+        return false;
+    }
+    if (BasePairs.size() > Opts.MaxRuntimeChecks) {
+        LLVM_DEBUG(dbgs() << "troppi controlli a runtime\n");
+        return false;
+    }
+    if (!canVersionLoops(Lj, Lk)) return false;
+
+    BasicBlock *PreHeader = Lj->getLoopPreheader();
+    for (auto &BP : BasePairs) {
+        RuntimeCheck C;
+        if (!getBaseRange(Lj, BP.first, SE, C.J) || !getBaseRange(Lk, BP.second, SE, C.K)) return false;
+        // i limiti devono essere calcolabili prima di entrare nel primo loop
+        for (const SCEV *S : {C.J.Low, C.J.High, C.K.Low, C.K.High})
+            if (!SE.properlyDominates(S, PreHeader)) return false;
+        Checks.push_back(C);
+    }
+    return true;
+}
+
+// La forma che fuseLoops sa fondere: IV canonica, header che fa il confronto
+// ed entra nel corpo con il primo successore, latch separato dal corpo e
+// un'unica uscita
+bool hasFusableShape(Loop *L) {
+    BasicBlock *Header = L->getHeader();
+    BasicBlock *Latch = L->getLoopLatch();
+    if (!L->getCanonicalInductionVariable() || !Latch || !L->getExitBlock() || L->getExitingBlock() != Header)
+        return false;
+    auto *Br = dyn_cast<BranchInst>(Header->getTerminator());
+    if (!Br || !Br->isConditional() || !L->contains(Br->getSuccessor(0)) || Br->getSuccessor(0) == Latch)
+        return false;
+    for (BasicBlock *Pred : predecessors(Latch))
+        if (L->contains(Pred))
+            return true;
+    return false;
+}
+
+bool canFuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, DominatorTree &DT, PostDominatorTree &PDT, ScalarEvolution &SE, DependenceInfo &DI, const LoopFusionOptions &Opts, SmallVectorImpl<RuntimeCheck> &Checks) {
+    // Condizione 0: fuseLoops deve saperli fondere; va controllato prima
+    // del versioning, che altrimenti lascerebbe due copie identiche
+    if (!hasFusableShape(Lj) || !hasFusableShape(Lk)) {
+      LLVM_DEBUG(dbgs() << "forma dei loop non supportata\n");
+      ++NumUnsupportedShape;
+      return false;
+    }
+
     // Condizione 1: Lj e Lk devono essere adiacenti
     if (!areAdjacent(Lj, Lk)) {
-      outs() << "non sono adiacenti\n";
+      LLVM_DEBUG(dbgs() << "non sono adiacenti\n");
+      ++NumNotAdjacent;
       return false;
     }
 
     // Condizione 2: Lj e Lk devono iterare lo stesso numero di volte
     if (!haveSameIterationCount(Lj, Lk, SE)) {
-      outs() << "non hanno lo stesso numero di iterazioni\n";
+      LLVM_DEBUG(dbgs() << "non hanno lo stesso numero di iterazioni\n");
+      ++NumTripCountMismatch;
       return false;
     }
 
     // Condizione 3: Lj e Lk devono essere equivalenti nel flusso di controllo
     if (!areControlFlowEquivalent(Lj, Lk, DT, PDT)){
-        outs() << "non sono control flow equivalent\n";
+        LLVM_DEBUG(dbgs() << "non sono control flow equivalent\n");
+        ++NumNotControlFlowEquivalent;
         return false;
     }
     // Condizione 4: Non ci devono essere dipendenze a distanza negativa
-    if (hasNegativeDistanceDependencies(Lj, Lk, DI)) return false;
+    if (hasNegativeDistanceDependencies(Lj, Lk, DI, SE)) {
+        ++NumNegativeDistance;
+        return false;
+    }
+
+    // Condizione 5: nessun valore dei loop deve servire dopo Lk
+    if (hasLiveOuts(Lj, Lk, DT)) {
+        LLVM_DEBUG(dbgs() << "valori usati dopo i loop\n");
+        ++NumLiveOut;
+        return false;
+    }
+
+    // Condizione 6: i possibili alias fra i due loop devono essere
+    // verificabili a runtime
+    if (!collectRuntimeChecks(Lj, Lk, DI, SE, Opts, Checks)) {
+        LLVM_DEBUG(dbgs() << "alias non verificabili\n");
+        ++NumAliasUnchecked;
+        return false;
+    }
 
     return true;
   }
 
-void fuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, ScalarEvolution &SE, DominatorTree &DT) {
+bool fuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, ScalarEvolution &SE, DominatorTree &DT) {
+    if (!hasFusableShape(Lj) || !hasFusableShape(Lk)) {
+        LLVM_DEBUG(dbgs() << "forma dei loop non supportata da fuseLoops\n");
+        return false;
+    }
     // Ottenere le variabili di induzione dei loop
     // funziona presa dalla documentazione: PHINode * 	getInductionVariable (ScalarEvolution &SE)
     PHINode *IV1 = Lj->getCanonicalInductionVariable(); 
     PHINode *IV2 = Lk->getCanonicalInductionVariable();
-    if (!IV1) {
-        outs() << "Impossibile trovare la variabile di induzione di lj.\n";
-        return;
-    }
-    if (!IV2) {
-        outs() << "Impossibile trovare la variabile di induzione di lk.\n";
-        return;
-    }
-    outs() << "variabili di induzione trovate\n";
+    LLVM_DEBUG(dbgs() << "variabili di induzione trovate\n");
     // Sostituire gli usi della variabile di induzione del loop 2
     for (auto *BB : Lk->blocks()) {
         for (auto &I : *BB) {
@@ -138,7 +405,7 @@ void fuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, ScalarEvolution &SE, DominatorT
             }
         }
     }
-    outs() << "variabili di induzione cambiate\n";
+    LLVM_DEBUG(dbgs() << "variabili di induzione cambiate\n");
     // Modificare il CFG per unire i corpi dei loop
     //ottengo tutti i basicblock che in seguito userò per collegare i vari blocchi
     BasicBlock *Header1 = Lj->getHeader();
@@ -156,7 +423,7 @@ void fuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, ScalarEvolution &SE, DominatorT
     for (BasicBlock *Pred : predecessors(Latch1)) {
         // Verifica se il predecessore appartiene al corpo del loop
         if(Lj->contains(Pred)){
-          outs() << "lastb1 trovato\n";
+          LLVM_DEBUG(dbgs() << "lastb1 trovato\n");
           LastB1 = Pred; 
           break;
         }
@@ -164,7 +431,7 @@ void fuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, ScalarEvolution &SE, DominatorT
     for (BasicBlock *Pred : predecessors(Latch2)) {
         // Verifica se il predecessore appartiene al corpo del loop
         if(Lk->contains(Pred)){
-          outs() << "lastb2 trovato\n";
+          LLVM_DEBUG(dbgs() << "lastb2 trovato\n");
           LastB2 = Pred; 
           break;
         }
@@ -180,17 +447,17 @@ void fuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, ScalarEvolution &SE, DominatorT
             Term->eraseFromParent();
             BranchInst::Create(TrueBlock, Exit2, Condition, Header1);
         }
-        else outs() << "non ha condizione\n";
+        else LLVM_DEBUG(dbgs() << "non ha condizione\n");
     }
-    else outs() << "terminatore dell'header non trovato\n";
+    else LLVM_DEBUG(dbgs() << "terminatore dell'header non trovato\n");
     
     if(LastB1){
       Instruction *Term = LastB1->getTerminator();
       if(Term){
         Term->eraseFromParent();
-        BranchInst::Create(LastB1, FirstB2); //collegare il body del loop 1 al body del loop 2
+        BranchInst::Create(FirstB2, LastB1); //collegare il body del loop 1 al body del loop 2
       }
-      else outs() << "term non trovato\n";
+      else LLVM_DEBUG(dbgs() << "term non trovato\n");
     }
     
     // Rimuovere il branch dal header del loop 2 al body del loop 2
@@ -198,9 +465,9 @@ void fuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, ScalarEvolution &SE, DominatorT
     Instruction *Term2 = Header2->getTerminator();
     if(Term2){
         Term2->eraseFromParent();
-        BranchInst::Create(Header2, Latch2);  //collegare l'header del loop 2 al latch del loop 2
+        BranchInst::Create(Latch2, Header2);  //collegare l'header del loop 2 al latch del loop 2
     }
-    else outs() << "term2 non trovato\n";
+    else LLVM_DEBUG(dbgs() << "term2 non trovato\n");
     }
 
 
@@ -209,35 +476,297 @@ void fuseLoops(Loop *Lj, Loop *Lk, LoopInfo &LI, ScalarEvolution &SE, DominatorT
     Instruction *Term4 = LastB2->getTerminator();
     if(Term4){
         Term4->eraseFromParent();
-        BranchInst::Create(LastB2, Latch1); // Collegare il body del loop 2 al latch del loop 1
+        BranchInst::Create(Latch1, LastB2); // Collegare il body del loop 2 al latch del loop 1
     }
-    else outs() << "term4 non trovato\n";
+    else LLVM_DEBUG(dbgs() << "term4 non trovato\n");
     }
-    
+    return true;
+}
+
+// Nuovo loop ID (distinto) con le proprieta' di LoopID, se c'e', piu' Attrs
+MDNode *addLoopAttributes(LLVMContext &Ctx, MDNode *LoopID, ArrayRef<Metadata *> Attrs) {
+    // il primo operando del loop ID e' il nodo stesso, lo sistemiamo alla fine
+    SmallVector<Metadata *, 4> MDs;
+    MDs.push_back(nullptr);
+    if (LoopID)
+        for (unsigned i = 1; i < LoopID->getNumOperands(); ++i)
+            MDs.push_back(LoopID->getOperand(i));
+    MDs.append(Attrs.begin(), Attrs.end());
+    MDNode *NewLoopID = MDNode::getDistinct(Ctx, MDs);
+    NewLoopID->replaceOperandWith(0, NewLoopID);
+    return NewLoopID;
+}
+
+// Duplica i due loop e li mette dietro ai controlli di alias: se gli
+// intervalli si sovrappongono si eseguono le copie (loop originali, non
+// fusi), altrimenti Lj e Lk, che vengono poi fusi dal chiamante
+void versionLoops(Loop *Lj, Loop *Lk, ArrayRef<RuntimeCheck> Checks, LoopInfo &LI, DominatorTree &DT, ScalarEvolution &SE) {
+    BasicBlock *CheckBB = Lj->getLoopPreheader();
+    Function *F = CheckBB->getParent();
+
+    // il vecchio preheader diventa il blocco dei controlli, il nuovo contiene solo il salto all'header
+    BasicBlock *PreHeader = SplitBlock(CheckBB, CheckBB->getTerminator(), &DT, &LI);
+
+    SmallVector<BasicBlock *, 16> Region;
+    Region.push_back(PreHeader);
+    getVersionedRegion(Lj, Lk, Region);
+
+    ValueToValueMapTy VMap;
+    SmallVector<BasicBlock *, 16> Cloned;
+    for (auto *BB : Region) {
+        BasicBlock *NewBB = CloneBasicBlock(BB, VMap, ".nofuse", F);
+        VMap[BB] = NewBB;
+        Cloned.push_back(NewBB);
+    }
+    remapInstructionsInBlocks(Cloned, VMap);
+
+    // le copie sono la versione da non fondere: senza il marcatore il giro
+    // successivo di run le riproverebbe, versionandole di nuovo
+    LLVMContext &Ctx = F->getContext();
+    MDNode *NoFusion = MDNode::get(Ctx, MDString::get(Ctx, "llvm.loop.fusion.disable"));
+    for (Loop *L : {Lj, Lk}) {
+        Instruction *LatchTerm = cast<BasicBlock>(VMap[L->getLoopLatch()])->getTerminator();
+        LatchTerm->setMetadata(LLVMContext::MD_loop, addLoopAttributes(Ctx, L->getLoopID(), NoFusion));
+    }
+
+    // Conflict = OR di (LowJ < HighK && LowK < HighJ)
+    SCEVExpander Expander(SE, F->getParent()->getDataLayout(), "lf.memcheck");
+    Instruction *Term = CheckBB->getTerminator();
+    IRBuilder<> Builder(Term);
+    Value *Conflict = nullptr;
+    for (auto &C : Checks) {
+        Type *Ty = C.J.Low->getType();
+        Value *LowJ = Expander.expandCodeFor(C.J.Low, Ty, Term);
+        Value *HighJ = Expander.expandCodeFor(C.J.High, Ty, Term);
+        Value *LowK = Expander.expandCodeFor(C.K.Low, Ty, Term);
+        Value *HighK = Expander.expandCodeFor(C.K.High, Ty, Term);
+        Value *Overlap = Builder.CreateAnd(Builder.CreateICmpULT(LowJ, HighK, "lf.bound0"),
+                                           Builder.CreateICmpULT(LowK, HighJ, "lf.bound1"), "lf.overlap");
+        Conflict = Conflict ? Builder.CreateOr(Conflict, Overlap, "lf.conflict") : Overlap;
+    }
+    BranchInst::Create(cast<BasicBlock>(VMap[PreHeader]), PreHeader, Conflict, CheckBB);
+    Term->eraseFromParent();
+}
+
+// Controlla che nessuna coppia di accessi in memoria del loop abbia una
+// dipendenza portata dal loop stesso (direzione diversa da '=' al suo livello)
+bool isDependenceFree(Loop *L, DependenceInfo &DI) {
+    SmallVector<Instruction *, 16> MemInsts;
+    for (auto *BB : L->blocks()) {
+        for (auto &I : *BB) {
+            if (!I.mayReadOrWriteMemory()) continue;
+            // chiamate e accessi volatili/atomici non li sappiamo analizzare
+            if (auto *LD = dyn_cast<LoadInst>(&I)) {
+                if (!LD->isSimple()) return false;
+            }
+            else if (auto *ST = dyn_cast<StoreInst>(&I)) {
+                if (!ST->isSimple()) return false;
+            }
+            else return false;
+            MemInsts.push_back(&I);
+        }
+    }
+
+    unsigned Level = L->getLoopDepth();
+    for (unsigned i = 0; i < MemInsts.size(); ++i) {
+        for (unsigned j = i; j < MemInsts.size(); ++j) {
+            Instruction *Src = MemInsts[i], *Dst = MemInsts[j];
+            if (isa<LoadInst>(Src) && isa<LoadInst>(Dst)) continue; // due letture non creano dipendenze
+            auto Dep = DI.depends(Src, Dst, true);
+            if (!Dep) continue;
+            if (Dep->isConfused() || Dep->getLevels() < Level) return false;
+            if (Dep->getDirection(Level) != Dependence::DVEntry::EQ) return false;
+        }
+    }
+    return true;
+}
+
+// Aggiunge llvm.loop.parallel_accesses (con un access group su ogni accesso)
+// e llvm.loop.vectorize.enable: LoopVectorize puo' cosi' vettorizzare senza
+// controlli di alias a runtime
+void addParallelLoopMetadata(Loop *L) {
+    LLVMContext &Ctx = L->getHeader()->getContext();
+    MDNode *AccessGroup = MDNode::getDistinct(Ctx, {});
+    for (auto *BB : L->blocks())
+        for (auto &I : *BB)
+            if (I.mayReadOrWriteMemory())
+                I.setMetadata(LLVMContext::MD_access_group,
+                              uniteAccessGroups(I.getMetadata(LLVMContext::MD_access_group), AccessGroup));
+
+    L->setLoopID(addLoopAttributes(Ctx, L->getLoopID(), {
+        MDNode::get(Ctx, {MDString::get(Ctx, "llvm.loop.parallel_accesses"), AccessGroup}),
+        MDNode::get(Ctx, {MDString::get(Ctx, "llvm.loop.vectorize.enable"),
+                          ConstantAsMetadata::get(ConstantInt::getTrue(Ctx))})}));
+}
+
+bool annotateIfParallel(Loop *L, DependenceInfo &DI) {
+    // il vettorizzatore lavora solo sui loop innermost
+    if (!L->isInnermost() || !L->getLoopLatch() || L->isAnnotatedParallel()) return false;
+    if (!isDependenceFree(L, DI)) return false;
+    addParallelLoopMetadata(L);
+    ++NumAnnotatedParallel;
+    LLVM_DEBUG(dbgs() << "loopfusion: " << L->getName() << " marcato come parallelo\n");
+    return true;
 }
 
 PreservedAnalyses LoopFussion::run(Function &F, FunctionAnalysisManager &FAM) {
-  LoopInfo &LI = FAM.getResult<LoopAnalysis>(F);
-  DominatorTree &DT = FAM.getResult<DominatorTreeAnalysis>(F);
-  PostDominatorTree &PDT = FAM.getResult<PostDominatorTreeAnalysis>(F);
-  ScalarEvolution &SE = FAM.getResult<ScalarEvolutionAnalysis>(F);
-  DependenceInfo &DI = FAM.getResult<DependenceAnalysis>(F);
+  CachedFunction Cache(F, AnnotateOnly ? Twine("loopfusion-annotate")
+                                       : "loopfusion;max-chain=" + Twine(Opts.MaxChain) +
+                                             ";allow-guarded=" + Twine(Opts.AllowGuarded) +
+                                             ";max-runtime-checks=" + Twine(Opts.MaxRuntimeChecks));
+  if (Cache.isHit())
+    return Cache.getHitResult();
+
+  if (AnnotateOnly) {
+    LoopInfo &LI = FAM.getResult<LoopAnalysis>(F);
+    DependenceInfo &DI = FAM.getResult<DependenceAnalysis>(F);
+    bool Annotated = false;
+    for (Loop *L : LI.getLoopsInPreorder())
+      Annotated |= annotateIfParallel(L, DI);
+    if (!Annotated)
+      return Cache.store(PreservedAnalyses::all());
+    PreservedAnalyses PA;
+    PA.preserveSet<CFGAnalyses>();
+    return Cache.store(PA);
+  }
   
-  outs() << "inizio esecuzione\n";
-    for (auto It = LI.begin(), E = LI.end(); It != E; It++) {
-      outs()<<"esecuzione loop\n";
+  bool Fused = false;
+  SmallVector<BasicBlock *, 4> FusedHeaders;
+  // quanti loop contiene ogni loop fuso, indicato dal suo header (quello del
+  // primo loop della catena)
+  DenseMap<BasicBlock *, unsigned> ChainLength;
+  auto getChainLength = [&](Loop *L) {
+    auto It = ChainLength.find(L->getHeader());
+    return It == ChainLength.end() ? 1u : It->second;
+  };
+  // ogni giro fonde coppie di loop consecutivi; se max-chain lo permette si
+  // rifanno le analisi e si riprova con i loop appena fusi. Un giro si
+  // ferma dopo il primo versioning e il successivo riparte dall'inizio
+  unsigned Round = 0, MaxRounds = 0;
+  for (bool FusedInRound = true; FusedInRound; ) {
+    FusedInRound = false;
+    bool Versioned = false;
+    LoopInfo &LI = FAM.getResult<LoopAnalysis>(F);
+    // ogni giro utile fonde almeno una coppia, e i loop da fondere calano
+    // di uno (le copie di versionLoops non contano): piu' giri dei loop
+    // iniziali vorrebbero dire che qualcosa viene rifuso all'infinito
+    if (Round++ == 0)
+      MaxRounds = LI.getTopLevelLoops().size();
+    DominatorTree &DT = FAM.getResult<DominatorTreeAnalysis>(F);
+    PostDominatorTree &PDT = FAM.getResult<PostDominatorTreeAnalysis>(F);
+    ScalarEvolution &SE = FAM.getResult<ScalarEvolutionAnalysis>(F);
+    DependenceInfo &DI = FAM.getResult<DependenceAnalysis>(F);
+
+    // LoopInfo tiene i loop top-level in ordine inverso rispetto al programma
+    for (auto It = LI.rbegin(), E = LI.rend(); It != E; It++) {
       Loop* L = *It;
       auto nextL = std::next(It);
       if(nextL == E) break;
       Loop* L2 = *nextL;
+      LLVM_DEBUG(dbgs() << "loopfusion: " << F.getName() << ": " << L->getName()
+                        << " e " << L2->getName() << "\n");
+      ++NumCandidates;
+
+      // copie non fuse lasciate da versionLoops (o loop marcati dall'utente)
+      if (getBooleanLoopAttribute(L, "llvm.loop.fusion.disable") ||
+          getBooleanLoopAttribute(L2, "llvm.loop.fusion.disable")) {
+        LLVM_DEBUG(dbgs() << "fusione disabilitata\n");
+        continue;
+      }
+
+      unsigned Length = getChainLength(L) + getChainLength(L2);
+      if (Length > Opts.MaxChain) {
+        LLVM_DEBUG(dbgs() << "catena troppo lunga (" << Length << " loop)\n");
+        ++NumChainTooLong;
+        continue;
+      }
     
-      if (canFuseLoops(L, L2, LI, DT, PDT, SE, DI)) {
-        outs() << "sono dentro\n";
-        fuseLoops(L, L2, LI, SE, DT);
+      SmallVector<RuntimeCheck, 4> Checks;
+      bool CanFuse;
+      {
+        TimeTraceScope TimeScope("LoopFussion::canFuseLoops", L->getName());
+        CanFuse = canFuseLoops(L, L2, LI, DT, PDT, SE, DI, Opts, Checks);
       }
+      if (CanFuse) {
+        TimeTraceScope TimeScope("LoopFussion::fuseLoops", L->getName());
+        if (!Checks.empty()) {
+          versionLoops(L, L2, Checks, LI, DT, SE);
+          ++NumVersioned;
+          NumRuntimeChecks += Checks.size();
+        }
+        // canFuseLoops ha gia' controllato la forma che fuseLoops richiede
+        bool FusedPair = fuseLoops(L, L2, LI, SE, DT);
+        assert(FusedPair && "fuseLoops ha rifiutato una coppia legale");
+        (void)FusedPair;
+        ++NumFused;
+        LLVM_DEBUG(dbgs() << "loopfusion: fusi" << (Checks.empty() ? "" : " con controlli a runtime") << "\n");
+        Fused = FusedInRound = true;
+        if (!ChainLength.count(L->getHeader()))
+          FusedHeaders.push_back(L->getHeader());
+        ChainLength[L->getHeader()] = Length;
+        // il versioning aggiunge blocchi che LoopInfo, i dominatori e le
+        // altre analisi non conoscono: il resto della funzione lo si guarda
+        // nel giro successivo, con le analisi ricalcolate
+        if (!Checks.empty()) {
+          Versioned = true;
+          break;
+        }
+        It++; // L2 non esiste piu' come loop a se'
+        if (It == E) break;
+      }
+    }
+    // con max-chain=2 ogni loop fuso ha gia' raggiunto il limite, ma dopo un
+    // versioning restano da vedere le coppie che seguono
+    if (!FusedInRound || (Opts.MaxChain <= 2 && !Versioned))
+      break;
+    if (Round >= MaxRounds) {
+      LLVM_DEBUG(dbgs() << "loopfusion: " << F.getName() << ": troppi giri\n");
+      break;
     }
+    FAM.invalidate(F, PreservedAnalyses::none());
+  }
   
-  return PreservedAnalyses::all();
+  // dopo una fusione CFG e LoopInfo sono cambiati: i pass successivi
+  // (es. loopscalarrepl) devono ricalcolarli
+  if (Fused) {
+    // ricalcoliamo le analisi sul CFG fuso e marchiamo i loop ottenuti che
+    // non hanno piu' dipendenze loop-carried
+    FAM.invalidate(F, PreservedAnalyses::none());
+    LoopInfo &FusedLI = FAM.getResult<LoopAnalysis>(F);
+    DependenceInfo &FusedDI = FAM.getResult<DependenceAnalysis>(F);
+    for (BasicBlock *Header : FusedHeaders) {
+      Loop *FL = FusedLI.getLoopFor(Header);
+      if (FL && FL->getHeader() == Header)
+        annotateIfParallel(FL, FusedDI);
+    }
+    return Cache.store(PreservedAnalyses::none());
+  }
+  return Cache.store(PreservedAnalyses::all());
 }
 
-
+Expected<LoopFusionOptions> llvm::parseLoopFusionOptions(StringRef Params) {
+  LoopFusionOptions Opts;
+  while (!Params.empty()) {
+    StringRef ParamName;
+    std::tie(ParamName, Params) = Params.split(';');
+    StringRef Value = ParamName;
+    if (ParamName == "allow-guarded" || ParamName == "no-allow-guarded") {
+      Opts.AllowGuarded = ParamName == "allow-guarded";
+    } else if (Value.consume_front("max-chain=")) {
+      if (Value.getAsInteger(0, Opts.MaxChain) || Opts.MaxChain < 2)
+        return make_error<StringError>(
+            formatv("loopfusion: max-chain vuole un intero >= 2: '{0}'", ParamName).str(),
+            inconvertibleErrorCode());
+    } else if (Value.consume_front("max-runtime-checks=")) {
+      if (Value.getAsInteger(0, Opts.MaxRuntimeChecks))
+        return make_error<StringError>(
+            formatv("loopfusion: max-runtime-checks vuole un intero: '{0}'", ParamName).str(),
+            inconvertibleErrorCode());
+    } else {
+      return make_error<StringError>(
+          formatv("loopfusion: parametro sconosciuto '{0}'", ParamName).str(),
+          inconvertibleErrorCode());
+    }
+  }
+  return Opts;
+}
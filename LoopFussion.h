@@ -6,11 +6,39 @@
 #include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/Analysis/DependenceAnalysis.h"
 #include "llvm/Analysis/PostDominators.h"
+#include "llvm/Support/Error.h"
 
 namespace llvm {
+    // Opzioni di loopfusion<...> (vedi parseLoopFusionOptions)
+    struct LoopFusionOptions {
+        // numero massimo di loop fusi in uno solo; con 2 si fondono solo
+        // coppie, oltre il pass rifa' le analisi e fonde anche i loop ottenuti
+        unsigned MaxChain = 2;
+        // fonde anche le coppie legali solo dietro controlli di alias a runtime
+        bool AllowGuarded = true;
+        // oltre questa soglia il costo dei controlli supera il guadagno della fusione
+        unsigned MaxRuntimeChecks = 8;
+    };
+
     class LoopFussion : public  PassInfoMixin<LoopFussion> {
-          public : PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM);
+          public :
+            // con AnnotateOnly il pass non fonde: marca soltanto come paralleli
+            // i loop senza dipendenze loop-carried
+            LoopFussion(bool AnnotateOnly = false, LoopFusionOptions Opts = LoopFusionOptions())
+                : AnnotateOnly(AnnotateOnly), Opts(Opts) {}
+            PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM);
+          private :
+            bool AnnotateOnly;
+            LoopFusionOptions Opts;
     };
+
+    // "max-chain=N;allow-guarded;no-allow-guarded;max-runtime-checks=N", per PassRegistry.def
+    Expected<LoopFusionOptions> parseLoopFusionOptions(StringRef Params);
 }
+
+// Usata anche da LoopUnrollJam: attacca il corpo di Lk a quello di Lj, che
+// devono avere la forma header (confronto) -> corpo -> latch. Restituisce
+// false, senza toccare nulla, se uno dei due loop non ha questa forma.
+bool fuseLoops(llvm::Loop *Lj, llvm::Loop *Lk, llvm::LoopInfo &LI, llvm::ScalarEvolution &SE, llvm::DominatorTree &DT);
 #endif
 
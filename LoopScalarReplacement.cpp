@@ -0,0 +1,226 @@
+//===-- LoopScalarReplacement.cpp - Forwarding store->load nei loop -------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Dopo la fusione lo stesso corpo contiene sia lo store a[i] (dal primo loop)
+// sia il load a[i-d] (dal secondo). Il valore letto e' quello salvato d
+// iterazioni prima: invece di rileggerlo dalla memoria lo portiamo avanti in
+// d PHI nell'header, che ad ogni iterazione scorrono di una posizione.
+//
+//===----------------------------------------------------------------------===//
+#include "llvm/Transforms/Utils/LoopScalarReplacement.h"
+#include "llvm/Transforms/Utils/PassCache.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Transforms/Utils/ScalarEvolutionExpander.h"
+#include <llvm/ADT/SmallVector.h>
+using namespace llvm;
+
+#define DEBUG_TYPE "loopscalarrepl"
+
+STATISTIC(NumForwarded, "Load sostituiti con valori portati in registro");
+
+// Oltre questa distanza i registri rotanti costano piu' del load che tolgono
+static cl::opt<unsigned> MaxCarriedDistance(
+    "loopscalarrepl-max-distance", cl::init(4), cl::Hidden,
+    cl::desc("Distanza massima (in iterazioni) di un valore portato nei PHI"));
+
+// Coppia produttore/consumatore: Load legge cio' che Store ha scritto
+// Distance iterazioni prima (0 = nella stessa iterazione)
+struct CarriedPair {
+  StoreInst *Store;
+  LoadInst *Load;
+  unsigned Distance;
+};
+
+// Restituisce l'AddRec affine di Ptr nel loop L, con passo costante
+static const SCEVAddRecExpr *getAffineAccess(Value *Ptr, Loop *L, ScalarEvolution &SE) {
+  auto *AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(Ptr));
+  if (!AR || AR->getLoop() != L || !AR->isAffine())
+    return nullptr;
+  if (!isa<SCEVConstant>(AR->getStepRecurrence(SE)))
+    return nullptr;
+  return AR;
+}
+
+// Nessun'altra istruzione del loop, a parte Store, puo' scrivere nella
+// memoria letta da Load
+static bool isOnlyWriter(Loop *L, StoreInst *Store, LoadInst *Load, AAResults &AA) {
+  MemoryLocation LoadLoc = MemoryLocation::getBeforeOrAfter(Load->getPointerOperand());
+  for (auto *BB : L->blocks()) {
+    for (auto &I : *BB) {
+      if (&I == Store || !I.mayWriteToMemory())
+        continue;
+      auto *SI = dyn_cast<StoreInst>(&I);
+      if (!SI) // chiamate, atomiche, ...
+        return false;
+      if (!AA.isNoAlias(MemoryLocation::getBeforeOrAfter(SI->getPointerOperand()), LoadLoc))
+        return false;
+    }
+  }
+  return true;
+}
+
+// Se Store e' il produttore del valore letto da Load restituisce la distanza
+// di dipendenza in iterazioni, altrimenti -1
+static int getCarriedDistance(Loop *L, StoreInst *Store, LoadInst *Load, ScalarEvolution &SE, const DataLayout &DL) {
+  if (!Store->isSimple() || !Load->isSimple())
+    return -1;
+  if (Store->getValueOperand()->getType() != Load->getType())
+    return -1;
+  const SCEVAddRecExpr *StoreAR = getAffineAccess(Store->getPointerOperand(), L, SE);
+  const SCEVAddRecExpr *LoadAR = getAffineAccess(Load->getPointerOperand(), L, SE);
+  if (!StoreAR || !LoadAR)
+    return -1;
+  if (StoreAR->getStepRecurrence(SE) != LoadAR->getStepRecurrence(SE))
+    return -1;
+  int64_t Step = cast<SCEVConstant>(StoreAR->getStepRecurrence(SE))->getAPInt().getSExtValue();
+  // con accessi piu' larghi del passo store e load si sovrapporrebbero solo in parte
+  uint64_t Size = DL.getTypeStoreSize(Load->getType()).getFixedSize();
+  if (Step == 0 || Size > (uint64_t)std::abs(Step))
+    return -1;
+  // indirizzo dello store all'iterazione m: S + m*Step, del load all'iterazione n: L + n*Step
+  // coincidono per m = n - (S - L)/Step
+  auto *Diff = dyn_cast<SCEVConstant>(SE.getMinusSCEV(StoreAR->getStart(), LoadAR->getStart()));
+  if (!Diff)
+    return -1;
+  int64_t Bytes = Diff->getAPInt().getSExtValue();
+  if (Bytes % Step != 0)
+    return -1;
+  int64_t Distance = Bytes / Step;
+  // distanza negativa: il load legge un valore che verra' scritto in futuro
+  if (Distance < 0 || Distance > MaxCarriedDistance)
+    return -1;
+  return Distance;
+}
+
+static bool isForwardable(Loop *L, const CarriedPair &P, DominatorTree &DT, ScalarEvolution &SE) {
+  BasicBlock *Latch = L->getLoopLatch();
+  if (P.Distance == 0)
+    return DT.dominates(P.Store, P.Load); // lo store deve precedere il load nella stessa iterazione
+
+  // lo store deve essere eseguito ad ogni iterazione, altrimenti il registro
+  // conterrebbe un valore vecchio
+  if (!DT.dominates(P.Store->getParent(), Latch))
+    return false;
+  // i primi Distance valori vengono letti nel preheader: serve che il loop
+  // li avrebbe letti comunque, altrimenti il load sarebbe speculativo
+  if (!DT.dominates(P.Load->getParent(), Latch))
+    return false;
+  const SCEV *BTC = SE.getBackedgeTakenCount(L);
+  auto *BTCConst = dyn_cast<SCEVConstant>(BTC);
+  return BTCConst && BTCConst->getAPInt().uge(P.Distance);
+}
+
+// Sostituisce il load con una catena di Distance PHI rotanti nell'header:
+// R1 = valore salvato all'iterazione precedente, Rk = R(k-1) dell'iterazione
+// precedente. Il load legge R(Distance).
+static void carryInRegisters(Loop *L, const CarriedPair &P, ScalarEvolution &SE) {
+  LoadInst *Load = P.Load;
+  if (P.Distance == 0) {
+    Load->replaceAllUsesWith(P.Store->getValueOperand());
+    Load->eraseFromParent();
+    return;
+  }
+
+  BasicBlock *Header = L->getHeader();
+  BasicBlock *PreHeader = L->getLoopPreheader();
+  BasicBlock *Latch = L->getLoopLatch();
+  const SCEVAddRecExpr *LoadAR = getAffineAccess(Load->getPointerOperand(), L, SE);
+  int64_t Step = cast<SCEVConstant>(LoadAR->getStepRecurrence(SE))->getAPInt().getSExtValue();
+
+  // valori letti dal load nelle prime Distance iterazioni
+  SCEVExpander Expander(SE, Header->getModule()->getDataLayout(), "lsr.fwd");
+  IRBuilder<> Builder(PreHeader->getTerminator());
+  SmallVector<Value *, 4> Initial;
+  for (unsigned K = 0; K < P.Distance; ++K) {
+    const SCEV *Addr = LoadAR->evaluateAtIteration(SE.getConstant(LoadAR->getStepRecurrence(SE)->getType(), K), SE);
+    Value *Ptr = Expander.expandCodeFor(Addr, Load->getPointerOperandType(), PreHeader->getTerminator());
+    Align A = commonAlignment(Load->getAlign(), K * std::abs(Step));
+    Initial.push_back(Builder.CreateAlignedLoad(Load->getType(), Ptr, A, "lsr.init"));
+  }
+
+  // catena di PHI: Rk parte dal valore dell'iterazione Distance-k
+  Value *Prev = P.Store->getValueOperand();
+  PHINode *Last = nullptr;
+  for (unsigned K = 1; K <= P.Distance; ++K) {
+    PHINode *Phi = PHINode::Create(Load->getType(), 2, "lsr.carry", &Header->front());
+    Phi->addIncoming(Initial[P.Distance - K], PreHeader);
+    Phi->addIncoming(Prev, Latch);
+    Prev = Phi;
+    Last = Phi;
+  }
+  Load->replaceAllUsesWith(Last);
+  Load->eraseFromParent();
+}
+
+static bool forwardCarriedValues(Loop *L, DominatorTree &DT, ScalarEvolution &SE, AAResults &AA) {
+  // servono preheader e latch unici per agganciare i PHI; i loop fusi sono
+  // sempre innermost, quelli esterni li lasciamo stare
+  if (!L->isInnermost() || !L->getLoopPreheader() || !L->getLoopLatch())
+    return false;
+  const DataLayout &DL = L->getHeader()->getModule()->getDataLayout();
+
+  SmallVector<StoreInst *, 8> Stores;
+  SmallVector<LoadInst *, 8> Loads;
+  for (auto *BB : L->blocks()) {
+    for (auto &I : *BB) {
+      if (auto *SI = dyn_cast<StoreInst>(&I))
+        Stores.push_back(SI);
+      else if (auto *LI = dyn_cast<LoadInst>(&I))
+        Loads.push_back(LI);
+    }
+  }
+
+  SmallVector<CarriedPair, 8> Pairs;
+  for (LoadInst *Load : Loads) {
+    for (StoreInst *Store : Stores) {
+      int Distance = getCarriedDistance(L, Store, Load, SE, DL);
+      if (Distance < 0)
+        continue;
+      CarriedPair P{Store, Load, (unsigned)Distance};
+      if (isOnlyWriter(L, Store, Load, AA) && isForwardable(L, P, DT, SE))
+        Pairs.push_back(P);
+      break; // al piu' un produttore per load
+    }
+  }
+
+  for (auto &P : Pairs) {
+    LLVM_DEBUG(dbgs() << "loopscalarrepl: " << *P.Load << " <- " << *P.Store
+                      << " (distanza " << P.Distance << ")\n");
+    carryInRegisters(L, P, SE);
+    ++NumForwarded;
+  }
+  if (!Pairs.empty())
+    SE.forgetLoop(L);
+  return !Pairs.empty();
+}
+
+PreservedAnalyses LoopScalarReplacement::run(Function &F, FunctionAnalysisManager &FAM) {
+  CachedFunction Cache(F, "loopscalarrepl;max-distance=" + Twine(MaxCarriedDistance));
+  if (Cache.isHit())
+    return Cache.getHitResult();
+  LoopInfo &LI = FAM.getResult<LoopAnalysis>(F);
+  DominatorTree &DT = FAM.getResult<DominatorTreeAnalysis>(F);
+  ScalarEvolution &SE = FAM.getResult<ScalarEvolutionAnalysis>(F);
+  AAResults &AA = FAM.getResult<AAManager>(F);
+
+  bool Changed = false;
+  for (Loop *L : LI.getLoopsInPreorder())
+    Changed |= forwardCarriedValues(L, DT, SE, AA);
+
+  if (!Changed)
+    return Cache.store(PreservedAnalyses::all());
+  // il CFG non cambia: aggiungiamo solo PHI e load nel preheader
+  PreservedAnalyses PA;
+  PA.preserveSet<CFGAnalyses>();
+  return Cache.store(PA);
+}
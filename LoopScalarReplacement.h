@@ -0,0 +1,18 @@
+#ifndef LLVM_TRANSFORMS_LOOPSCALARREPLACEMENT_H
+#define LLVM_TRANSFORMS_LOOPSCALARREPLACEMENT_H
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+
+namespace llvm {
+    // Da eseguire dopo loopfusion: i load che rileggono un valore salvato
+    // dal loop stesso a distanza costante vengono sostituiti da registri
+    // rotanti (PHI nell'header).
+    class LoopScalarReplacement : public PassInfoMixin<LoopScalarReplacement> {
+          public : PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM);
+    };
+}
+#endif
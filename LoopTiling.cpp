@@ -0,0 +1,385 @@
+//===-- LoopTiling.cpp - Interchange e cache blocking ---------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Lavora sulla coppia di loop piu' interna di un nest perfetto, con IV
+// canoniche e limiti invarianti:
+//   for (i = 0; i < N; i++)          for (jj = 0; jj < M; jj += T)
+//     for (j = 0; j < M; j++)   ->     for (i = 0; i < N; i++)
+//       body(i, j)                       for (j = jj; j < min(jj+T, M); j++)
+//                                          body(i, j)
+// L'interchange non sposta blocchi: scambia i limiti nei confronti di uscita
+// e le IV usate dal corpo. La legalita' usa le stesse direzioni di
+// DependenceInfo di LoopFussion.
+//
+//===----------------------------------------------------------------------===//
+#include "llvm/Transforms/Utils/LoopTiling.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/DependenceAnalysis.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Transforms/Utils/LoopUtils.h"
+#include <llvm/ADT/SmallVector.h>
+using namespace llvm;
+
+#define DEBUG_TYPE "looptile"
+
+STATISTIC(NumInterchanged, "Nest con i loop scambiati");
+STATISTIC(NumTiled, "Loop interni divisi in blocchi");
+
+static cl::opt<unsigned> TileCacheSize(
+    "looptile-cache-size", cl::init(0), cl::Hidden,
+    cl::desc("Byte di cache da usare per il tiling (0 = L1D da TargetTransformInfo)"));
+
+static cl::opt<unsigned> TileSizeOpt(
+    "looptile-size", cl::init(0), cl::Hidden,
+    cl::desc("Iterazioni del loop interno per blocco (0 = calcolate dalla cache)"));
+
+// Loop contato: IV canonica (parte da 0, passo 1) confrontata nel blocco
+// d'uscita con un limite invariante in tutta la coppia
+struct CountedLoop {
+	Loop *L;
+	PHINode *IV;
+	Instruction *Inc;
+	ICmpInst *Cmp;
+	unsigned BoundIdx;
+	Value *Bound;
+	// predicato con la IV (o l'incremento) a sinistra e il limite a destra
+	ICmpInst::Predicate Pred;
+	// il confronto usa l'incremento invece della PHI
+	bool CmpOnInc;
+	// successore del salto che esce dal loop
+	unsigned ExitIdx;
+};
+
+static bool analyzeCountedLoop(Loop *L, Loop *Outer, CountedLoop &CL) {
+	CL.L = L;
+	CL.IV = L->getCanonicalInductionVariable();
+	BasicBlock *Latch = L->getLoopLatch();
+	BasicBlock *Exiting = L->getExitingBlock();
+	if (!CL.IV || !Latch || !Exiting || !L->getExitBlock() || !L->getLoopPreheader())
+		return false;
+	// l'unica PHI deve essere la IV: altri valori portati fra le iterazioni
+	// non sopravvivrebbero allo scambio
+	if (std::next(L->getHeader()->phis().begin()) != L->getHeader()->phis().end())
+		return false;
+	CL.Inc = dyn_cast<Instruction>(CL.IV->getIncomingValueForBlock(Latch));
+	auto *Br = dyn_cast<BranchInst>(Exiting->getTerminator());
+	if (!CL.Inc || !Br || !Br->isConditional())
+		return false;
+	CL.Cmp = dyn_cast<ICmpInst>(Br->getCondition());
+	if (!CL.Cmp || !CL.Cmp->hasOneUse())
+		return false;
+	for (User *U : CL.Inc->users())
+		if (U != CL.IV && U != CL.Cmp)
+			return false;
+	CL.ExitIdx = L->contains(Br->getSuccessor(0)) ? 1 : 0;
+	for (unsigned Idx = 0; Idx < 2; ++Idx) {
+		Value *Op = CL.Cmp->getOperand(Idx);
+		if (Op != CL.IV && Op != CL.Inc)
+			continue;
+		CL.BoundIdx = 1 - Idx;
+		CL.Bound = CL.Cmp->getOperand(CL.BoundIdx);
+		CL.CmpOnInc = Op == CL.Inc;
+		CL.Pred = Idx == 0 ? CL.Cmp->getPredicate() : CL.Cmp->getSwappedPredicate();
+		auto *BoundInst = dyn_cast<Instruction>(CL.Bound);
+		return !BoundInst || !Outer->contains(BoundInst);
+	}
+	return false;
+}
+
+// Nest perfetto: fuori dal loop interno ci sono solo IV, confronti e salti, e
+// le IV sono usate (a parte incremento e confronto) solo nel loop interno
+static bool isPerfectPair(const CountedLoop &O, const CountedLoop &I) {
+	Loop *Outer = O.L, *Inner = I.L;
+	if (Outer->getSubLoops().size() != 1)
+		return false;
+	for (auto *BB : Outer->blocks()) {
+		for (auto &Inst : *BB) {
+			if (!Inner->contains(BB) && (Inst.mayHaveSideEffects() || Inst.mayReadFromMemory()))
+				return false;
+			for (User *U : Inst.users())
+				if (!Outer->contains(cast<Instruction>(U)))
+					return false;
+		}
+	}
+	for (const CountedLoop *CL : {&O, &I})
+		for (User *U : CL->IV->users())
+			if (U != CL->Inc && U != CL->Cmp && !Inner->contains(cast<Instruction>(U)))
+				return false;
+
+	// stessa forma (entrambi ruotati o entrambi con l'uscita nell'header) e
+	// nessuna guardia: cosi' il numero minimo di iterazioni non cambia
+	bool ORotated = Outer->getExitingBlock() == Outer->getLoopLatch();
+	bool IRotated = Inner->getExitingBlock() == Inner->getLoopLatch();
+	if (ORotated != IRotated || Outer->isGuarded() || Inner->isGuarded())
+		return false;
+	// lo scambio passa solo i limiti da un confronto all'altro: il numero di
+	// iterazioni si conserva se i due confronti hanno la stessa forma (stesso
+	// predicato, stesso valore confrontato, uscita sullo stesso successore)
+	return O.IV->getType() == I.IV->getType() && O.Pred == I.Pred &&
+	       O.CmpOnInc == I.CmpOnInc && O.ExitIdx == I.ExitIdx;
+}
+
+// Il tiling assume che il loop giri per IV in [inizio, limite): il confronto
+// che lo tiene nel loop deve essere <, o != visto che la IV ha passo 1, e
+// deve vedere il valore della IV per l'iterazione successiva (la PHI
+// nell'header, l'incremento nel latch di un loop ruotato)
+static bool hasExclusiveBound(const CountedLoop &CL) {
+	ICmpInst::Predicate Stay = CL.ExitIdx == 0 ? ICmpInst::getInversePredicate(CL.Pred) : CL.Pred;
+	if (Stay != ICmpInst::ICMP_SLT && Stay != ICmpInst::ICMP_ULT && Stay != ICmpInst::ICMP_NE)
+		return false;
+	bool Rotated = CL.L->getExitingBlock() == CL.L->getLoopLatch();
+	return CL.CmpOnInc == Rotated;
+}
+
+// Scambiare i due loop (o portare fuori i blocchi del loop interno) e'
+// legale se nessuna dipendenza ha direzione (<, >) o (>, <)
+static bool isPermutable(Loop *Outer, Loop *Inner, DependenceInfo &DI) {
+	SmallVector<Instruction *, 16> MemInsts;
+	for (auto *BB : Outer->blocks()) {
+		for (auto &I : *BB) {
+			if (!I.mayReadOrWriteMemory())
+				continue;
+			if (!isa<LoadInst>(I) && !isa<StoreInst>(I))
+				return false;
+			MemInsts.push_back(&I);
+		}
+	}
+	unsigned OuterLevel = Outer->getLoopDepth(), InnerLevel = Inner->getLoopDepth();
+	for (unsigned i = 0; i < MemInsts.size(); ++i) {
+		for (unsigned j = i; j < MemInsts.size(); ++j) {
+			if (isa<LoadInst>(MemInsts[i]) && isa<LoadInst>(MemInsts[j]))
+				continue;
+			auto Dep = DI.depends(MemInsts[i], MemInsts[j], true);
+			if (!Dep)
+				continue;
+			if (Dep->isConfused() || Dep->getLevels() < InnerLevel)
+				return false;
+			unsigned DO = Dep->getDirection(OuterLevel), DIn = Dep->getDirection(InnerLevel);
+			if ((DO & Dependence::DVEntry::LT) && (DIn & Dependence::DVEntry::GT))
+				return false;
+			if ((DO & Dependence::DVEntry::GT) && (DIn & Dependence::DVEntry::LT))
+				return false;
+		}
+	}
+	return true;
+}
+
+// Passo in byte dell'indirizzo S rispetto al loop L: 0 se invariante, -1 se
+// non e' una costante. L'AddRec di L puo' stare dentro quella del loop interno.
+static int64_t getStride(const SCEV *S, Loop *L, ScalarEvolution &SE) {
+	while (auto *AR = dyn_cast<SCEVAddRecExpr>(S)) {
+		if (AR->getLoop() == L) {
+			if (auto *C = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE)))
+				return std::abs(C->getAPInt().getSExtValue());
+			return -1;
+		}
+		S = AR->getStart();
+	}
+	return SE.isLoopInvariant(S, L) ? 0 : -1;
+}
+
+// Byte di linee di cache nuove toccati da un'iterazione se L fosse il loop
+// piu' interno: un passo unitario costa l'elemento, uno grande l'intera linea
+static uint64_t getInnerCost(ArrayRef<Instruction *> Accesses, Loop *L, unsigned LineSize, ScalarEvolution &SE) {
+	uint64_t Cost = 0;
+	for (Instruction *I : Accesses) {
+		int64_t Stride = getStride(SE.getSCEV(getLoadStorePointerOperand(I)), L, SE);
+		if (Stride == 0)
+			continue;
+		Cost += (Stride < 0 || (uint64_t)Stride > LineSize) ? LineSize : Stride;
+	}
+	return Cost;
+}
+
+// Scambia i ruoli dei due loop: ogni loop itera fino al limite dell'altro e
+// il corpo usa la IV dell'altro
+static void interchangeLoops(CountedLoop &O, CountedLoop &I) {
+	SmallVector<Use *, 8> OuterUses, InnerUses;
+	for (Use &U : O.IV->uses())
+		if (U.getUser() != O.Inc && U.getUser() != O.Cmp)
+			OuterUses.push_back(&U);
+	for (Use &U : I.IV->uses())
+		if (U.getUser() != I.Inc && U.getUser() != I.Cmp)
+			InnerUses.push_back(&U);
+	for (Use *U : OuterUses)
+		U->set(I.IV);
+	for (Use *U : InnerUses)
+		U->set(O.IV);
+	O.Cmp->setOperand(O.BoundIdx, I.Bound);
+	I.Cmp->setOperand(I.BoundIdx, O.Bound);
+	std::swap(O.Bound, I.Bound);
+}
+
+// Avvolge il loop esterno in un loop sui blocchi del loop interno (strip
+// mining del loop interno + interchange del loop dei blocchi fino in cima).
+// L'uscita del loop esterno non deve avere PHI (LCSSA): i valori del loop
+// esterno non arriverebbero piu' da un blocco che ne fa parte.
+// Restituisce il nuovo loop dei blocchi
+static Loop *tileInnerLoop(CountedLoop &O, CountedLoop &I, unsigned Tile, LoopInfo &LI, DominatorTree &DT) {
+	Loop *Outer = O.L;
+	BasicBlock *OuterPH = Outer->getLoopPreheader();
+	BasicBlock *OuterHeader = Outer->getHeader();
+	BasicBlock *OuterExiting = Outer->getExitingBlock();
+	BasicBlock *Exit = Outer->getExitBlock();
+	Function *F = OuterHeader->getParent();
+	LLVMContext &Ctx = F->getContext();
+	Type *Ty = I.IV->getType();
+	bool Signed = I.Cmp->isSigned();
+	Value *T = ConstantInt::get(Ty, Tile);
+
+	// tile.header: jj e fine del blocco, min(jj + T, M) calcolato senza overflow
+	BasicBlock *TileHeader = BasicBlock::Create(Ctx, "tile.header", F, OuterHeader);
+	BasicBlock *TileLatch = BasicBlock::Create(Ctx, "tile.latch", F, Exit);
+	IRBuilder<> Builder(TileHeader);
+	PHINode *JJ = Builder.CreatePHI(Ty, 2, "tile.iv");
+	Value *Rem = Builder.CreateSub(I.Bound, JJ, "tile.rem");
+	Value *IsLast = Signed ? Builder.CreateICmpSLT(Rem, T, "tile.last") : Builder.CreateICmpULT(Rem, T, "tile.last");
+	Value *TileEnd = Builder.CreateSelect(IsLast, I.Bound, Builder.CreateAdd(JJ, T, "tile.next"), "tile.end");
+	Builder.CreateBr(OuterHeader);
+
+	// tile.latch: passa al blocco successivo finche' ne restano
+	Builder.SetInsertPoint(TileLatch);
+	Value *JJNext = Builder.CreateAdd(JJ, T, "tile.iv.next");
+	Value *Left = Builder.CreateSub(I.Bound, JJ, "tile.left");
+	Value *More = Signed ? Builder.CreateICmpSGT(Left, T, "tile.more") : Builder.CreateICmpUGT(Left, T, "tile.more");
+	Builder.CreateCondBr(More, TileHeader, Exit);
+	JJ->addIncoming(ConstantInt::get(Ty, 0), OuterPH);
+	JJ->addIncoming(JJNext, TileLatch);
+
+	// il loop interno parte da jj e si ferma a fine blocco
+	I.IV->setIncomingValueForBlock(I.L->getLoopPreheader(), JJ);
+	I.Cmp->setOperand(I.BoundIdx, TileEnd);
+
+	// agganciamo il loop esterno fra tile.header e tile.latch
+	OuterPH->getTerminator()->replaceUsesOfWith(OuterHeader, TileHeader);
+	for (PHINode &PN : OuterHeader->phis())
+		PN.replaceIncomingBlockWith(OuterPH, TileHeader);
+	OuterExiting->getTerminator()->replaceUsesOfWith(Exit, TileLatch);
+
+	// nuovo loop in LoopInfo, padre del loop esterno
+	Loop *TileLoop = LI.AllocateLoop();
+	if (Loop *Parent = Outer->getParentLoop())
+		Parent->replaceChildLoopWith(Outer, TileLoop);
+	else
+		LI.changeTopLevelLoop(Outer, TileLoop);
+	TileLoop->addChildLoop(Outer);
+	TileLoop->addBasicBlockToLoop(TileHeader, LI);
+	TileLoop->addBasicBlockToLoop(TileLatch, LI);
+	for (auto *BB : Outer->blocks())
+		TileLoop->addBlockEntry(BB);
+	TileLoop->moveToHeader(TileHeader);
+
+	DT.recalculate(*F);
+	return TileLoop;
+}
+
+PreservedAnalyses LoopTiling::run(LoopNest &LN, LoopAnalysisManager &LAM,
+				  LoopStandardAnalysisResults &LAR, LPMUpdater &LU) {
+	Loop *Inner = LN.getInnermostLoop();
+	if (!Inner || !Inner->getParentLoop())
+		return PreservedAnalyses::all();
+	Loop *Outer = Inner->getParentLoop();
+	ScalarEvolution &SE = LAR.SE;
+
+	// nest gia' diviso in blocchi: quando il nuovo loop torna nella worklist
+	// non va ne' scambiato ne' diviso di nuovo
+	if (getBooleanLoopAttribute(Outer, "llvm.loop.tile.disable"))
+		return PreservedAnalyses::all();
+
+	CountedLoop O, I;
+	if (!analyzeCountedLoop(Outer, Outer, O) || !analyzeCountedLoop(Inner, Outer, I) || !isPerfectPair(O, I))
+		return PreservedAnalyses::all();
+	Function &F = *Outer->getHeader()->getParent();
+	DependenceInfo DI(&F, &LAR.AA, &SE, &LAR.LI);
+	if (!isPermutable(Outer, Inner, DI))
+		return PreservedAnalyses::all();
+
+	SmallVector<Instruction *, 16> Accesses;
+	for (auto *BB : Inner->blocks())
+		for (auto &Inst : *BB)
+			if (isa<LoadInst>(Inst) || isa<StoreInst>(Inst))
+				Accesses.push_back(&Inst);
+	if (Accesses.empty())
+		return PreservedAnalyses::all();
+
+	// Interchange: conviene se con l'altro loop all'interno gli accessi
+	// toccano meno linee di cache per iterazione
+	unsigned LineSize = LAR.TTI.getCacheLineSize();
+	if (!LineSize)
+		LineSize = 64;
+	bool Interchange = getInnerCost(Accesses, Outer, LineSize, SE) < getInnerCost(Accesses, Inner, LineSize, SE);
+	// dopo l'eventuale scambio, chi fa da loop interno e chi da esterno
+	Loop *NewInner = Interchange ? Outer : Inner;
+	Loop *NewOuter = Interchange ? Inner : Outer;
+
+	// Tiling: serve se un accesso invariante rispetto al loop esterno viene
+	// riletto ad ogni sua iterazione; il blocco deve stare nella cache
+	bool HasReuse = false;
+	uint64_t BytesPerIter = 0;
+	const DataLayout &DL = F.getParent()->getDataLayout();
+	for (Instruction *Acc : Accesses) {
+		const SCEV *S = SE.getSCEV(getLoadStorePointerOperand(Acc));
+		if (getStride(S, NewInner, SE) == 0)
+			continue;
+		BytesPerIter += DL.getTypeStoreSize(getLoadStoreType(Acc)).getFixedSize();
+		if (getStride(S, NewOuter, SE) == 0)
+			HasReuse = true;
+	}
+	unsigned Tile = TileSizeOpt;
+	if (!Tile && HasReuse && BytesPerIter) {
+		uint64_t CacheBytes = 32 * 1024;
+		if (TileCacheSize)
+			CacheBytes = TileCacheSize;
+		else if (auto L1Size = LAR.TTI.getCacheSize(TargetTransformInfo::CacheLevel::L1D))
+			CacheBytes = *L1Size;
+		// meta' cache per il blocco, il resto per gli altri accessi
+		Tile = PowerOf2Floor(CacheBytes / (2 * BytesPerIter));
+	}
+	// il limite del loop interno dopo lo scambio
+	Value *InnerBound = Interchange ? O.Bound : I.Bound;
+	if (auto *C = dyn_cast<ConstantInt>(InnerBound))
+		if (C->getValue().ule(Tile))
+			Tile = 0;
+	if (Tile < 2 || !hasExclusiveBound(I))
+		Tile = 0;
+	// valori del loop esterno usati dopo il nest: le PHI di LCSSA andrebbero
+	// ricostruite fuori dal loop dei blocchi, per ora rinunciamo al tiling
+	if (!Outer->getExitBlock()->phis().empty())
+		Tile = 0;
+
+	if (!Interchange && !Tile)
+		return PreservedAnalyses::all();
+
+	// i limiti e le IV cambiano per tutto il nest, anche per i loop che
+	// contengono la coppia
+	SE.forgetLoop(&LN.getOutermostLoop());
+	if (Interchange) {
+		LLVM_DEBUG(dbgs() << "looptile: interchange di " << Outer->getName() << "\n");
+		interchangeLoops(O, I);
+		++NumInterchanged;
+	}
+	if (Tile) {
+		LLVM_DEBUG(dbgs() << "looptile: blocchi da " << Tile << " iterazioni\n");
+		Loop *TileLoop = tileInnerLoop(O, I, Tile, LAR.LI, LAR.DT);
+		addStringMetadataToLoop(Outer, "llvm.loop.tile.disable", 1);
+		++NumTiled;
+		// se il loop esterno era la radice del nest, ora la radice e' il loop
+		// dei blocchi: lo rimettiamo nella worklist come nuovo nest
+		if (TileLoop->isOutermost())
+			LU.addSiblingLoops({TileLoop});
+		LU.markLoopNestChanged(true);
+	}
+	return getLoopPassPreservedAnalyses();
+}
@@ -0,0 +1,18 @@
+#ifndef LLVM_TRANSFORMS_LOOPTILING_H
+#define LLVM_TRANSFORMS_LOOPTILING_H
+
+#include "llvm/IR/PassManager.h"
+#include "llvm/Analysis/LoopAnalysisManager.h"
+#include "llvm/Analysis/LoopNestAnalysis.h"
+#include "llvm/Transforms/Scalar/LoopPassManager.h"
+namespace llvm {
+        // Interchange e tiling della coppia di loop piu' interna di un nest:
+        // prima scambia i loop se cosi' gli accessi interni diventano a passo
+        // unitario, poi divide il loop interno in blocchi che stanno in cache
+        class LoopTiling : public PassInfoMixin<LoopTiling> {
+               public : PreservedAnalyses run(LoopNest &LN, LoopAnalysisManager &LAM,
+						LoopStandardAnalysisResults &LAR,
+						LPMUpdater &LU);
+        };
+}
+#endif
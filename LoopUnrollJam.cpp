@@ -0,0 +1,350 @@
+//===-- LoopUnrollJam.cpp - Unroll-and-jam con fuseLoops ------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+//   for (i = 0; i < N; i++)            for (i = 0; i < N; i += 2)
+//     for (j = 0; j < M; j++)     ->     for (j = 0; j < M; j++) {
+//       body(i, j)                          body(i, j)
+//                                           body(i + 1, j)
+//                                         }
+// Il loop esterno viene srotolato clonando il loop interno U-1 volte (la
+// copia K usa i + K), poi le copie vengono fuse una dopo l'altra nel loop
+// interno originale con fuseLoops di LoopFussion.
+//
+//===----------------------------------------------------------------------===//
+#include "llvm/Transforms/Utils/LoopUnrollJam.h"
+#include "llvm/Transforms/Utils/LoopFussion.h"
+#include "llvm/Transforms/Utils/PassCache.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+using namespace llvm;
+
+#define DEBUG_TYPE "loopunrolljam"
+
+STATISTIC(NumUnrollJammed, "Nest srotolati e fusi");
+
+static cl::opt<unsigned> JamFactor(
+    "loopunrolljam-factor", cl::init(0), cl::Hidden,
+    cl::desc("Fattore di unroll del loop esterno (0 = stimato dalla pressione sui registri)"));
+
+static cl::opt<unsigned> MaxJamFactor(
+    "loopunrolljam-max-factor", cl::init(8), cl::Hidden,
+    cl::desc("Fattore di unroll massimo scelto dall'euristica"));
+
+// Nest di due loop adatto all'unroll-and-jam
+struct JamNest {
+  Loop *Outer;
+  Loop *Inner;
+  PHINode *IV;         // IV canonica del loop esterno
+  BinaryOperator *Inc; // IV + 1, diventa IV + Factor
+  unsigned TripCount;   // iterazioni del corpo del loop esterno
+  unsigned Factor;
+};
+
+// Header e latch delle copie spariscono con la fusione: devono contenere
+// solo la IV, il suo incremento, il confronto e i salti
+static bool isControlOnly(BasicBlock *BB, Loop *L, PHINode *IV) {
+  for (auto &I : *BB) {
+    if (&I == IV || I.isTerminator())
+      continue;
+    if (I.mayHaveSideEffects() || I.mayReadFromMemory())
+      return false;
+    for (User *U : I.users()) {
+      BasicBlock *UseBB = cast<Instruction>(U)->getParent();
+      if (UseBB != L->getHeader() && UseBB != L->getLoopLatch())
+        return false;
+    }
+  }
+  return true;
+}
+
+static bool analyzeNest(Loop *Outer, ScalarEvolution &SE, JamNest &N) {
+  if (Outer->getSubLoops().size() != 1 || !Outer->getSubLoops()[0]->isInnermost())
+    return false;
+  Loop *Inner = Outer->getSubLoops()[0];
+  N.Outer = Outer;
+  N.Inner = Inner;
+
+  // loop esterno: IV canonica e numero di iterazioni costante
+  N.IV = Outer->getCanonicalInductionVariable();
+  BasicBlock *OuterLatch = Outer->getLoopLatch();
+  BasicBlock *OuterExiting = Outer->getExitingBlock();
+  if (!N.IV || !OuterLatch || !OuterExiting || !Outer->getLoopPreheader())
+    return false;
+  N.Inc = dyn_cast<BinaryOperator>(N.IV->getIncomingValueForBlock(OuterLatch));
+  auto *OuterBr = dyn_cast<BranchInst>(OuterExiting->getTerminator());
+  if (!N.Inc || !OuterBr || !OuterBr->isConditional())
+    return false;
+  Value *OuterCmp = OuterBr->getCondition();
+  for (User *U : N.Inc->users())
+    if (U != N.IV && U != OuterCmp)
+      return false;
+  // con l'uscita nell'header il corpo esegue un'iterazione in meno del
+  // blocco d'uscita
+  N.TripCount = SE.getSmallConstantTripCount(Outer);
+  if (N.TripCount && OuterExiting != OuterLatch)
+    --N.TripCount;
+  if (N.TripCount < 2)
+    return false;
+
+  // loop interno nella forma che fuseLoops sa fondere: header con il
+  // confronto, corpo, latch separato
+  PHINode *InnerIV = Inner->getCanonicalInductionVariable();
+  BasicBlock *InnerPH = Inner->getLoopPreheader();
+  BasicBlock *Header = Inner->getHeader();
+  BasicBlock *Latch = Inner->getLoopLatch();
+  BasicBlock *InnerExit = Inner->getExitBlock();
+  if (!InnerIV || !InnerPH || !Latch || !InnerExit || Inner->getExitingBlock() != Header)
+    return false;
+  auto *Br = dyn_cast<BranchInst>(Header->getTerminator());
+  if (!Br || !Br->isConditional() || !Inner->contains(Br->getSuccessor(0)) || Br->getSuccessor(0) == Latch)
+    return false;
+  if (!Latch->getSinglePredecessor() || InnerExit->getSinglePredecessor() != Header || !InnerExit->phis().empty())
+    return false;
+  // altre PHI (valori portati in registro) resterebbero nell'header delle
+  // copie, che la fusione elimina
+  if (std::next(Header->phis().begin()) != Header->phis().end())
+    return false;
+  if (!isControlOnly(Header, Inner, InnerIV) || !isControlOnly(Latch, Inner, InnerIV))
+    return false;
+
+  // tutte le copie devono fare lo stesso numero di iterazioni
+  const SCEV *BTC = SE.getBackedgeTakenCount(Inner);
+  if (isa<SCEVCouldNotCompute>(BTC) || !SE.isLoopInvariant(BTC, Outer))
+    return false;
+
+  // nest perfetto: fuori dal loop interno c'e' solo il controllo del loop
+  // esterno; il preheader interno viene replicato, quindi solo calcoli puri
+  for (auto *BB : Outer->blocks()) {
+    if (Inner->contains(BB))
+      continue;
+    for (auto &I : *BB) {
+      if (I.mayHaveSideEffects() || I.mayReadFromMemory())
+        return false;
+      if (BB != InnerPH && &I != N.IV && &I != N.Inc && &I != OuterCmp && !I.isTerminator())
+        return false;
+    }
+  }
+  // le copie non hanno un'uscita comune per i loro risultati
+  for (auto *BB : Inner->blocks())
+    for (auto &I : *BB)
+      for (User *U : I.users())
+        if (!Inner->contains(cast<Instruction>(U)))
+          return false;
+  return true;
+}
+
+// Dopo il jam l'iterazione (i + a, j) precede (i + b, j') se j < j', oppure
+// se j = j' e a < b. Una dipendenza portata dal loop esterno dentro la
+// finestra di Factor iterazioni diventa sbagliata se ha distanza negativa sul
+// loop interno: e' il controllo di distanza negativa della fusione, fatto
+// sul livello del loop interno (DependenceInfo non confronta i livelli di
+// due loop fratelli, quindi non si puo' chiedere direttamente sulle copie).
+static bool isJamLegal(const JamNest &N, DependenceInfo &DI) {
+  SmallVector<Instruction *, 16> MemInsts;
+  for (auto *BB : N.Inner->blocks()) {
+    for (auto &I : *BB) {
+      if (!I.mayReadOrWriteMemory())
+        continue;
+      if (!isa<LoadInst>(I) && !isa<StoreInst>(I))
+        return false;
+      MemInsts.push_back(&I);
+    }
+  }
+  unsigned OuterLevel = N.Outer->getLoopDepth(), InnerLevel = N.Inner->getLoopDepth();
+  for (unsigned i = 0; i < MemInsts.size(); ++i) {
+    for (unsigned j = i; j < MemInsts.size(); ++j) {
+      if (isa<LoadInst>(MemInsts[i]) && isa<LoadInst>(MemInsts[j]))
+        continue;
+      auto Dep = DI.depends(MemInsts[i], MemInsts[j], true);
+      if (!Dep)
+        continue;
+      if (Dep->isConfused() || Dep->getLevels() < InnerLevel)
+        return false;
+      // iterazioni esterne lontane almeno Factor finiscono in blocchi diversi
+      if (auto *D = dyn_cast_or_null<SCEVConstant>(Dep->getDistance(OuterLevel)))
+        if (D->getAPInt().abs().uge(N.Factor))
+          continue;
+      unsigned DO = Dep->getDirection(OuterLevel), DIn = Dep->getDirection(InnerLevel);
+      if ((DO & Dependence::DVEntry::LT) && (DIn & Dependence::DVEntry::GT))
+        return false;
+      if ((DO & Dependence::DVEntry::GT) && (DIn & Dependence::DVEntry::LT))
+        return false;
+    }
+  }
+  return true;
+}
+
+// L'indirizzo cambia da un'iterazione del loop esterno all'altra
+static bool variesWithOuter(Value *Ptr, const JamNest &N, ScalarEvolution &SE) {
+  const SCEV *S = SE.getSCEV(Ptr);
+  return SCEVExprContains(S, [&](const SCEV *E) {
+    if (auto *AR = dyn_cast<SCEVAddRecExpr>(E))
+      return AR->getLoop() == N.Outer;
+    if (auto *U = dyn_cast<SCEVUnknown>(E))
+      if (auto *I = dyn_cast<Instruction>(U->getValue()))
+        return N.Outer->contains(I);
+    return false;
+  });
+}
+
+// Fattore di unroll: ogni copia aggiunge i valori che dipendono dal loop
+// esterno, mentre quelli che non ne dipendono (i load riusati) restano
+// condivisi. Si srotola finche' tutto sta nei registri di ogni classe.
+static unsigned getJamFactor(const JamNest &N, ScalarEvolution &SE, const TargetTransformInfo &TTI) {
+  if (JamFactor)
+    return JamFactor;
+  DenseMap<unsigned, unsigned> Shared, PerCopy;
+  // IV e limite del loop interno
+  Shared[TTI.getRegisterClassForType(false, N.IV->getType())] += 2;
+  bool HasReuse = false;
+  for (auto *BB : N.Inner->blocks()) {
+    for (auto &I : *BB) {
+      Value *Ptr = getLoadStorePointerOperand(&I);
+      if (!Ptr)
+        continue;
+      unsigned ClassID = TTI.getRegisterClassForType(false, getLoadStoreType(&I));
+      if (variesWithOuter(Ptr, N, SE))
+        ++PerCopy[ClassID];
+      else if (isa<LoadInst>(I)) {
+        ++Shared[ClassID];
+        HasReuse = true;
+      }
+    }
+  }
+  // senza load condivisi srotolare non toglie accessi alla memoria
+  if (!HasReuse)
+    return 1;
+  unsigned Factor = MaxJamFactor;
+  for (auto &Entry : PerCopy) {
+    unsigned Regs = TTI.getNumberOfRegisters(Entry.first);
+    unsigned Free = Regs > Shared[Entry.first] ? Regs - Shared[Entry.first] : 0;
+    Factor = std::min(Factor, Free / Entry.second);
+  }
+  return Factor;
+}
+
+static void unrollAndJam(JamNest &N, LoopInfo &LI, DominatorTree &DT, ScalarEvolution &SE) {
+  Loop *Outer = N.Outer, *Inner = N.Inner;
+  BasicBlock *InnerPH = Inner->getLoopPreheader();
+  BasicBlock *InnerExit = Inner->getExitBlock();
+  Function *F = InnerPH->getParent();
+  SE.forgetLoop(Outer);
+
+  // copie 1..Factor-1 del loop interno, prima di InnerExit. Si clona tutto
+  // prima di toccare il loop originale: ogni copia esce ancora su InnerExit
+  // e il preheader clonato non contiene gli i + K delle copie precedenti.
+  SmallVector<Loop *, 8> Copies;
+  SmallVector<Instruction *, 8> Shifted;
+  for (unsigned K = 1; K < N.Factor; ++K) {
+    ValueToValueMapTy VMap;
+    SmallVector<BasicBlock *, 8> Blocks;
+    Loop *Copy = cloneLoopWithPreheader(InnerExit, Inner->getHeader(), Inner, VMap, ".uj" + Twine(K), &LI, &DT, Blocks);
+    Instruction *IVPlusK = BinaryOperator::CreateAdd(N.IV, ConstantInt::get(N.IV->getType(), K), "uj.iv" + Twine(K));
+    VMap[N.IV] = IVPlusK;
+    remapInstructionsInBlocks(Blocks, VMap);
+    Copies.push_back(Copy);
+    Shifted.push_back(IVPlusK);
+  }
+  // in fila: il loop K esce nel preheader della copia K+1. fuseLoops salta
+  // il preheader delle copie, quindi i suoi calcoli vanno nel preheader
+  // originale, che domina tutte le copie fuse.
+  BasicBlock *PrevExiting = Inner->getHeader();
+  for (unsigned K = 0; K < Copies.size(); ++K) {
+    BasicBlock *CopyPH = Copies[K]->getLoopPreheader();
+    PrevExiting->getTerminator()->replaceUsesOfWith(InnerExit, CopyPH);
+    PrevExiting = Copies[K]->getHeader();
+    Shifted[K]->insertBefore(InnerPH->getTerminator());
+    while (&CopyPH->front() != CopyPH->getTerminator())
+      CopyPH->front().moveBefore(InnerPH->getTerminator());
+  }
+
+  // fusione in sequenza: dopo ogni passo il corpo della copia entra nel loop
+  // interno, cosi' fuseLoops trova l'ultimo blocco del corpo gia' fuso
+  SmallVector<BasicBlock *, 16> Dead;
+  for (Loop *Copy : Copies) {
+    BasicBlock *CopyPH = Copy->getLoopPreheader();
+    BasicBlock *CopyHeader = Copy->getHeader();
+    BasicBlock *CopyLatch = Copy->getLoopLatch();
+    // analyzeNest ha gia' chiesto al loop interno la forma di fuseLoops
+    bool Fused = fuseLoops(Inner, Copy, LI, SE, DT);
+    assert(Fused && "copia del loop interno non fondibile");
+    (void)Fused;
+
+    SmallVector<BasicBlock *, 8> CopyBlocks(Copy->blocks().begin(), Copy->blocks().end());
+    for (auto *BB : CopyBlocks) {
+      if (BB == CopyHeader || BB == CopyLatch)
+        continue;
+      Copy->removeBlockFromLoop(BB);
+      Inner->addBlockEntry(BB);
+      LI.changeLoopFor(BB, Inner);
+    }
+    for (auto *BB : {CopyPH, CopyHeader, CopyLatch}) {
+      LI.removeBlock(BB);
+      Dead.push_back(BB);
+    }
+    Outer->removeChildLoop(Copy);
+    LI.destroy(Copy);
+  }
+  DeleteDeadBlocks(Dead);
+
+  // le copie coprono Factor iterazioni del loop esterno, che divide il
+  // numero di iterazioni
+  N.Inc->setOperand(1, ConstantInt::get(N.IV->getType(), N.Factor));
+  DT.recalculate(*F);
+}
+
+PreservedAnalyses LoopUnrollJam::run(Function &F, FunctionAnalysisManager &FAM) {
+  // il fattore dipende anche dai registri del target
+  TargetTransformInfo &TTI = FAM.getResult<TargetIRAnalysis>(F);
+  CachedFunction Cache(F, "loopunrolljam;factor=" + Twine(JamFactor) + ";max-factor=" +
+                              Twine(MaxJamFactor) + ";regs=" +
+                              Twine(TTI.getNumberOfRegisters(TTI.getRegisterClassForType(false))) +
+                              "," + Twine(TTI.getNumberOfRegisters(TTI.getRegisterClassForType(true))));
+  if (Cache.isHit())
+    return Cache.getHitResult();
+  LoopInfo &LI = FAM.getResult<LoopAnalysis>(F);
+  DominatorTree &DT = FAM.getResult<DominatorTreeAnalysis>(F);
+  ScalarEvolution &SE = FAM.getResult<ScalarEvolutionAnalysis>(F);
+  DependenceInfo &DI = FAM.getResult<DependenceAnalysis>(F);
+
+  // prima tutte le analisi, poi le trasformazioni: i nest sono disgiunti
+  // perche' il loop esterno ha come unico figlio un loop innermost
+  SmallVector<JamNest, 4> Nests;
+  for (Loop *L : LI.getLoopsInPreorder()) {
+    JamNest N;
+    if (!analyzeNest(L, SE, N))
+      continue;
+    N.Factor = std::min(getJamFactor(N, SE, TTI), N.TripCount);
+    while (N.Factor > 1 && N.TripCount % N.Factor)
+      --N.Factor;
+    if (N.Factor < 2 || !isJamLegal(N, DI))
+      continue;
+    Nests.push_back(N);
+  }
+
+  for (JamNest &N : Nests) {
+    LLVM_DEBUG(dbgs() << "loopunrolljam: " << N.Outer->getName() << " srotolato di "
+                      << N.Factor << "\n");
+    unrollAndJam(N, LI, DT, SE);
+    ++NumUnrollJammed;
+  }
+  if (Nests.empty())
+    return Cache.store(PreservedAnalyses::all());
+  PreservedAnalyses PA;
+  PA.preserve<LoopAnalysis>();
+  PA.preserve<DominatorTreeAnalysis>();
+  return Cache.store(PA);
+}
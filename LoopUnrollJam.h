@@ -0,0 +1,18 @@
+#ifndef LLVM_TRANSFORMS_LOOPUNROLLJAM_H
+#define LLVM_TRANSFORMS_LOOPUNROLLJAM_H
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/DependenceAnalysis.h"
+#include "llvm/Analysis/LoopInfo.h"
+
+namespace llvm {
+    // Unroll-and-jam: srotola il loop esterno di un nest perfetto e fonde
+    // con fuseLoops le copie del loop interno, cosi' i load che non dipendono
+    // dal loop esterno vengono riusati da tutte le copie
+    class LoopUnrollJam : public PassInfoMixin<LoopUnrollJam> {
+          public : PreservedAnalyses run(Function &F, FunctionAnalysisManager &FAM);
+    };
+}
+#endif
@@ -13,8 +13,17 @@
 #include <llvm/IR/Constants.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/IR/Dominators.h>
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FormatVariadic.h"
 using namespace llvm;
 
+#define DEBUG_TYPE "loopwalk"
+
+STATISTIC(NumInvariant, "Istruzioni loop-invariant trovate");
+STATISTIC(NumHoisted, "Istruzioni spostate nel preheader");
+STATISTIC(NumOverLimit, "Istruzioni lasciate nel loop per max-hoist");
+
 // Funzione che controlla se un'istruzione è LoopInvariant
 bool isLoopInvariant(Instruction& Inst, Loop& L, const std::vector <Instruction*> &invariantInstructions) {
 	bool isInvariant = true;
@@ -108,6 +117,7 @@ PreservedAnalyses LoopWalk::run(Loop &L, LoopAnalysisManager &LAM, LoopStandardA
 				invariantInstructions.push_back(&Inst); // gli passo l'istruzione stessa, e non l'indirizzo
 		}
 	}
+	NumInvariant += invariantInstructions.size();
 	
 //Con il metodo di L ottengo tutti i blocchi successoti del loop
 	SmallVector<BasicBlock*> exitBlocks;
@@ -127,11 +137,39 @@ PreservedAnalyses LoopWalk::run(Loop &L, LoopAnalysisManager &LAM, LoopStandardA
 	
 	//sposto le istruzioni nel preheader
 	BasicBlock* PreHeader = L.getLoopPreheader();
+	unsigned Hoisted = 0;
 	for (Instruction* I : candidateInst) {
+		//con max-hoist ci fermiamo alle prime istruzioni, che non dipendono dalle successive
+		if (Opts.MaxHoist && Hoisted == Opts.MaxHoist) {
+			++NumOverLimit;
+			continue;
+		}
 		if (dependenciesMoved(I, candidateInst, L)) {
+			LLVM_DEBUG(dbgs() << "loopwalk: " << *I << " spostata in " << PreHeader->getName() << "\n");
 			I->moveBefore(PreHeader->getTerminator());
+			++NumHoisted;
+			++Hoisted;
 		}
 	}
 	return PreservedAnalyses::all();
 }
 
+Expected<LoopWalkOptions> llvm::parseLoopWalkOptions(StringRef Params) {
+	LoopWalkOptions Opts;
+	while (!Params.empty()) {
+		StringRef ParamName;
+		std::tie(ParamName, Params) = Params.split(';');
+		StringRef Value = ParamName;
+		if (Value.consume_front("max-hoist=")) {
+			if (Value.getAsInteger(0, Opts.MaxHoist))
+				return make_error<StringError>(
+					formatv("looppass: max-hoist vuole un intero: '{0}'", ParamName).str(),
+					inconvertibleErrorCode());
+		}
+		else
+			return make_error<StringError>(
+				formatv("looppass: parametro sconosciuto '{0}'", ParamName).str(),
+				inconvertibleErrorCode());
+	}
+	return Opts;
+}
@@ -4,13 +4,27 @@
 #include "llvm/IR/PassManager.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/Analysis/LoopAnalysisManager.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Transforms/Scalar/LoopPassManager.h"
 namespace llvm {
+        // Opzioni di looppass<...> (vedi parseLoopWalkOptions)
+        struct LoopWalkOptions {
+                // istruzioni spostate al massimo per loop, 0 = nessun limite;
+                // ogni istruzione spostata occupa un registro per tutto il loop
+                unsigned MaxHoist = 0;
+        };
+
         class LoopWalk : public PassInfoMixin<LoopWalk> {
-               public : PreservedAnalyses run(Loop &L, LoopAnalysisManager &LAM,
+               public :
+                        LoopWalk(LoopWalkOptions Opts = LoopWalkOptions()) : Opts(Opts) {}
+                        PreservedAnalyses run(Loop &L, LoopAnalysisManager &LAM,
 						LoopStandardAnalysisResults &LAR,
 						LPMUpdater &LU);
+               private :
+                        LoopWalkOptions Opts;
         };
+
+        // "max-hoist=N", per PassRegistry.def
+        Expected<LoopWalkOptions> parseLoopWalkOptions(StringRef Params);
 }
 #endif
-
@@ -0,0 +1,578 @@
+//===-- PassCache.cpp - Cache su disco dei pass di funzione ---------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// La directory della cache contiene un file "index", mappato in memoria da
+// ogni processo che la usa, e un file bitcode per ogni risultato. L'indice e'
+// una tabella hash a indirizzamento aperto con un numero fisso di slot; ogni
+// accesso avviene con il file bloccato, quindi piu' opt in parallelo possono
+// usare la stessa cache. Quando i file superano -custom-pass-cache-size-mb, o
+// la tabella e' piena per tre quarti, si tolgono le voci usate meno di recente.
+//
+// StructuralHash guarda solo la forma della funzione (opcode e tipi) e serve a
+// scegliere lo slot; l'uguaglianza vera la da' l'MD5 del testo. Restano fuori
+// le funzioni con debug info (i metadati del compile unit non si possono
+// ricollegare al modulo) e quelle che usano alias, ifunc, blockaddress o
+// globali senza nome.
+//
+//===----------------------------------------------------------------------===//
+#include "llvm/Transforms/Utils/PassCache.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/StructuralHash.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallVector.h>
+#include <cstring>
+#include <vector>
+using namespace llvm;
+
+#define DEBUG_TYPE "passcache"
+
+STATISTIC(NumHits, "Funzioni prese dalla cache");
+STATISTIC(NumMisses, "Funzioni non trovate in cache");
+STATISTIC(NumStores, "Risultati salvati in cache");
+STATISTIC(NumEvicted, "Voci tolte dalla cache (LRU)");
+STATISTIC(NumUncacheable, "Funzioni che non si possono mettere in cache");
+
+static cl::opt<std::string> CacheDir(
+    "custom-pass-cache-dir", cl::value_desc("directory"),
+    cl::desc("Directory della cache dei risultati dei nostri pass (vuota = niente cache)"));
+
+static cl::opt<unsigned> CacheSizeMB(
+    "custom-pass-cache-size-mb", cl::init(512),
+    cl::desc("Dimensione massima dei risultati in cache, in MiB"));
+
+static cl::opt<unsigned> CacheEntries(
+    "custom-pass-cache-entries", cl::init(65536),
+    cl::desc("Slot dell'indice, usato solo quando la cache viene creata"));
+
+// il risultato dipende anche dal codice dei pass: chi li compila deve
+// cambiare il sale a ogni versione (per esempio con l'hash del commit)
+static cl::opt<std::string> CacheSalt(
+    "custom-pass-cache-salt", cl::init(""),
+    cl::desc("Stringa aggiunta alla chiave della cache"));
+
+namespace {
+
+const char IndexMagic[8] = {'L', 'C', 'P', 'C', 'A', 'C', 'H', 'E'};
+const uint32_t IndexVersion = 1;
+const char *const TypeTableName = "passcache.types";
+
+struct IndexHeader {
+  char Magic[8];
+  uint32_t Version;
+  uint32_t Capacity;   // slot della tabella
+  uint64_t Entries;    // slot occupati
+  uint64_t TotalBytes; // somma delle dimensioni dei file
+  uint64_t Clock;      // cresce a ogni accesso, per l'LRU
+};
+
+enum EntryState : uint16_t { Empty = 0, Used = 1, Deleted = 2 };
+
+struct IndexEntry {
+  uint64_t StructHash;
+  uint8_t Digest[16];
+  uint64_t LastUse;
+  uint32_t Size;    // byte del file bitcode, 0 se il pass non ha cambiato F
+  uint16_t State;
+  uint16_t Changed;
+};
+static_assert(sizeof(IndexHeader) == 40 && sizeof(IndexEntry) == 40,
+              "il formato dell'indice non deve dipendere dal compilatore");
+
+using Key = CachedFunction::Key;
+
+bool warn(const Twine &Msg) {
+  errs() << "custom-pass-cache: " << Msg << "\n";
+  return false;
+}
+
+// Blocca il file dell'indice per la durata dello scope
+class IndexLock {
+public:
+  IndexLock(int FD) : FD(FD), Locked(!sys::fs::lockFile(FD)) {}
+  ~IndexLock() {
+    if (Locked)
+      sys::fs::unlockFile(FD);
+  }
+  explicit operator bool() const { return Locked; }
+
+private:
+  int FD;
+  bool Locked;
+};
+
+class PassCache {
+public:
+  // nullptr se la cache e' spenta o non si puo' aprire
+  static PassCache *get();
+  ~PassCache();
+
+  bool lookup(const Key &K, bool &Changed);
+  void insert(const Key &K, uint32_t Size, bool Changed);
+  std::string getPath(uint64_t StructHash, const uint8_t *Digest) const;
+  std::string getPath(const Key &K) const { return getPath(K.StructHash, K.Digest.data()); }
+
+private:
+  bool open();
+  IndexHeader *header() { return reinterpret_cast<IndexHeader *>(Region.data()); }
+  IndexEntry *entries() {
+    return reinterpret_cast<IndexEntry *>(Region.data() + sizeof(IndexHeader));
+  }
+  IndexEntry *find(uint64_t StructHash, const uint8_t *Digest, bool ForInsert);
+  void evict();
+
+  int FD = -1;
+  sys::fs::mapped_file_region Region;
+};
+
+PassCache *PassCache::get() {
+  static PassCache Cache;
+  static bool Opened = !CacheDir.empty() && Cache.open();
+  return Opened ? &Cache : nullptr;
+}
+
+PassCache::~PassCache() {
+  Region.unmap();
+  if (FD >= 0)
+    sys::fs::closeFile(FD);
+}
+
+bool PassCache::open() {
+  if (std::error_code EC = sys::fs::create_directories(CacheDir))
+    return warn(CacheDir + ": " + EC.message());
+  SmallString<128> Path(CacheDir);
+  sys::path::append(Path, "index");
+  if (std::error_code EC = sys::fs::openFileForReadWrite(Path, FD, sys::fs::CD_OpenAlways,
+                                                         sys::fs::OF_None))
+    return warn(Path + ": " + EC.message());
+
+  // chi crea l'indice lo inizializza tenendo il lock, gli altri aspettano
+  IndexLock Lock(FD);
+  if (!Lock)
+    return warn(Path + ": impossibile bloccare il file");
+  sys::fs::file_status Status;
+  if (std::error_code EC = sys::fs::status(FD, Status))
+    return warn(Path + ": " + EC.message());
+  uint64_t Size = Status.getSize();
+  bool Create = Size == 0;
+  if (Create) {
+    Size = sizeof(IndexHeader) + uint64_t(std::max(CacheEntries.getValue(), 16u)) * sizeof(IndexEntry);
+    if (std::error_code EC = sys::fs::resize_file(FD, Size))
+      return warn(Path + ": " + EC.message());
+  } else if (Size < sizeof(IndexHeader)) {
+    return warn(Path + ": indice non valido");
+  }
+
+  std::error_code EC;
+  Region = sys::fs::mapped_file_region(sys::fs::convertFDToNativeFile(FD),
+                                       sys::fs::mapped_file_region::readwrite, Size, 0, EC);
+  if (EC)
+    return warn(Path + ": " + EC.message());
+  IndexHeader *H = header();
+  if (Create) {
+    // il file nuovo e' tutto a zero: gli slot sono gia' vuoti
+    memcpy(H->Magic, IndexMagic, sizeof(IndexMagic));
+    H->Version = IndexVersion;
+    H->Capacity = (Size - sizeof(IndexHeader)) / sizeof(IndexEntry);
+  } else if (memcmp(H->Magic, IndexMagic, sizeof(IndexMagic)) || H->Version != IndexVersion ||
+             Size != sizeof(IndexHeader) + uint64_t(H->Capacity) * sizeof(IndexEntry)) {
+    Region.unmap();
+    return warn(Path + ": indice non valido");
+  }
+  return true;
+}
+
+std::string PassCache::getPath(uint64_t StructHash, const uint8_t *Digest) const {
+  SmallString<128> Path(CacheDir);
+  sys::path::append(Path, utohexstr(StructHash, /*LowerCase=*/true) + "-" +
+                              toHex(ArrayRef<uint8_t>(Digest, 16), /*LowerCase=*/true) + ".bc");
+  return std::string(Path);
+}
+
+// Slot della chiave, oppure (con ForInsert) il primo slot libero dove metterla
+IndexEntry *PassCache::find(uint64_t StructHash, const uint8_t *Digest, bool ForInsert) {
+  uint32_t Capacity = header()->Capacity;
+  IndexEntry *Free = nullptr;
+  for (uint32_t i = 0; i < Capacity; ++i) {
+    IndexEntry &E = entries()[(StructHash + i) % Capacity];
+    if (E.State == Empty)
+      return ForInsert ? (Free ? Free : &E) : nullptr;
+    if (E.State == Deleted) {
+      if (!Free)
+        Free = &E;
+      continue;
+    }
+    if (E.StructHash == StructHash && !memcmp(E.Digest, Digest, sizeof(E.Digest)))
+      return &E;
+  }
+  return ForInsert ? Free : nullptr;
+}
+
+bool PassCache::lookup(const Key &K, bool &Changed) {
+  IndexLock Lock(FD);
+  if (!Lock)
+    return false;
+  IndexEntry *E = find(K.StructHash, K.Digest.data(), false);
+  if (!E)
+    return false;
+  E->LastUse = ++header()->Clock;
+  Changed = E->Changed;
+  return true;
+}
+
+void PassCache::insert(const Key &K, uint32_t Size, bool Changed) {
+  IndexLock Lock(FD);
+  if (!Lock)
+    return;
+  IndexHeader *H = header();
+  IndexEntry *E = find(K.StructHash, K.Digest.data(), true);
+  if (!E) {
+    evict();
+    if (!(E = find(K.StructHash, K.Digest.data(), true)))
+      return;
+  }
+  if (E->State == Used)
+    H->TotalBytes -= E->Size;
+  else
+    ++H->Entries;
+  E->StructHash = K.StructHash;
+  memcpy(E->Digest, K.Digest.data(), sizeof(E->Digest));
+  E->LastUse = ++H->Clock;
+  E->Size = Size;
+  E->State = Used;
+  E->Changed = Changed;
+  H->TotalBytes += Size;
+  if (H->TotalBytes > uint64_t(CacheSizeMB) << 20 || H->Entries > uint64_t(H->Capacity) * 3 / 4)
+    evict();
+}
+
+// Tiene le voci piu' recenti fino al 90% del limite di spazio e a meta' degli
+// slot, poi ricostruisce la tabella senza gli slot cancellati
+void PassCache::evict() {
+  IndexHeader *H = header();
+  std::vector<IndexEntry> Live;
+  for (uint32_t i = 0; i < H->Capacity; ++i)
+    if (entries()[i].State == Used)
+      Live.push_back(entries()[i]);
+  llvm::sort(Live, [](const IndexEntry &A, const IndexEntry &B) { return A.LastUse > B.LastUse; });
+
+  uint64_t MaxBytes = (uint64_t(CacheSizeMB) << 20) / 10 * 9;
+  uint64_t Bytes = 0;
+  size_t Keep = 0;
+  while (Keep < Live.size() && Keep < H->Capacity / 2 && Bytes + Live[Keep].Size <= MaxBytes)
+    Bytes += Live[Keep++].Size;
+  for (size_t i = Keep; i < Live.size(); ++i) {
+    if (Live[i].Size)
+      sys::fs::remove(getPath(Live[i].StructHash, Live[i].Digest));
+    ++NumEvicted;
+  }
+  Live.resize(Keep);
+
+  memset(entries(), 0, uint64_t(H->Capacity) * sizeof(IndexEntry));
+  for (IndexEntry &E : Live)
+    *find(E.StructHash, E.Digest, true) = E;
+  H->Entries = Live.size();
+  H->TotalBytes = Bytes;
+}
+
+// Riporta i tipi struct del bitcode letto a quelli del contesto con lo stesso
+// nome: il reader crea tipi nuovi (struct.S.0) se il nome e' gia' usato
+class StructRemapper : public ValueMapTypeRemapper {
+public:
+  void add(Type *From, Type *To) { Map[From] = To; }
+
+  Type *remapType(Type *Ty) override {
+    auto It = Map.find(Ty);
+    if (It != Map.end())
+      return It->second;
+    Type *New = Ty;
+    if (auto *AT = dyn_cast<ArrayType>(Ty)) {
+      New = ArrayType::get(remapType(AT->getElementType()), AT->getNumElements());
+    } else if (auto *VT = dyn_cast<VectorType>(Ty)) {
+      New = VectorType::get(remapType(VT->getElementType()), VT->getElementCount());
+    } else if (auto *FT = dyn_cast<FunctionType>(Ty)) {
+      SmallVector<Type *, 8> Params;
+      for (Type *P : FT->params())
+        Params.push_back(remapType(P));
+      New = FunctionType::get(remapType(FT->getReturnType()), Params, FT->isVarArg());
+    } else if (auto *ST = dyn_cast<StructType>(Ty)) {
+      if (ST->isLiteral()) {
+        SmallVector<Type *, 8> Elements;
+        for (Type *E : ST->elements())
+          Elements.push_back(remapType(E));
+        New = StructType::get(Ty->getContext(), Elements, ST->isPacked());
+      }
+    }
+    Map[Ty] = New;
+    return New;
+  }
+
+private:
+  DenseMap<Type *, Type *> Map;
+};
+
+// Modulo con la sola definizione di F e le dichiarazioni di cio' che usa;
+// nullptr se F usa qualcosa che non sapremmo ricollegare
+std::unique_ptr<Module> extractFunction(Function &F) {
+  if (F.getSubprogram() || F.hasPrefixData() || F.hasPrologueData())
+    return nullptr;
+  Module &M = *F.getParent();
+  auto Out = std::make_unique<Module>("passcache", F.getContext());
+  Out->setDataLayout(M.getDataLayout());
+  Out->setTargetTriple(M.getTargetTriple());
+  Function *NewF = Function::Create(F.getFunctionType(), F.getLinkage(), F.getAddressSpace(),
+                                    F.getName(), Out.get());
+  ValueToValueMapTy VMap;
+  VMap[&F] = NewF;
+
+  // i globali usati, anche dentro espressioni costanti
+  SmallVector<const Constant *, 16> Worklist;
+  SmallPtrSet<const Constant *, 16> Visited;
+  auto Visit = [&](const Value *V) {
+    if (auto *C = dyn_cast<Constant>(V))
+      if (Visited.insert(C).second)
+        Worklist.push_back(C);
+  };
+  for (Instruction &I : instructions(F))
+    for (const Value *Op : I.operands())
+      Visit(Op);
+  if (F.hasPersonalityFn())
+    Visit(F.getPersonalityFn());
+  while (!Worklist.empty()) {
+    const Constant *C = Worklist.pop_back_val();
+    if (isa<BlockAddress>(C))
+      return nullptr;
+    auto *GV = dyn_cast<GlobalValue>(C);
+    if (!GV) {
+      for (const Value *Op : C->operands())
+        Visit(Op);
+      continue;
+    }
+    if (GV == &F)
+      continue;
+    if (!GV->hasName())
+      return nullptr;
+    if (auto *G = dyn_cast<Function>(GV)) {
+      Function *Decl = Function::Create(G->getFunctionType(), GlobalValue::ExternalLinkage,
+                                        G->getAddressSpace(), G->getName(), Out.get());
+      Decl->setAttributes(G->getAttributes());
+      Decl->setCallingConv(G->getCallingConv());
+      VMap[G] = Decl;
+    } else if (auto *G = dyn_cast<GlobalVariable>(GV)) {
+      auto *Decl = new GlobalVariable(*Out, G->getValueType(), G->isConstant(),
+                                      GlobalValue::ExternalLinkage, nullptr, G->getName(), nullptr,
+                                      G->getThreadLocalMode(), G->getAddressSpace());
+      Decl->setAlignment(G->getAlign());
+      VMap[G] = Decl;
+    } else {
+      return nullptr;
+    }
+  }
+
+  auto NewArg = NewF->arg_begin();
+  for (Argument &A : F.args()) {
+    NewArg->setName(A.getName());
+    VMap[&A] = &*NewArg++;
+  }
+  SmallVector<ReturnInst *, 4> Returns;
+  CloneFunctionInto(NewF, &F, VMap, CloneFunctionChangeType::DifferentModule, Returns);
+  // senza debug info resta solo un !llvm.dbg.cu vuoto, che il reader
+  // segnalerebbe come debug info senza versione
+  if (NamedMDNode *CUs = Out->getNamedMetadata("llvm.dbg.cu"))
+    Out->eraseNamedMetadata(CUs);
+  return Out;
+}
+
+// Nome e tipo di ogni struct del modulo salvato, per StructRemapper
+void addTypeTable(Module &M) {
+  NamedMDNode *Table = M.getOrInsertNamedMetadata(TypeTableName);
+  LLVMContext &Ctx = M.getContext();
+  for (StructType *ST : M.getIdentifiedStructTypes())
+    if (ST->hasName() && !ST->isOpaque())
+      Table->addOperand(MDNode::get(Ctx, {MDString::get(Ctx, ST->getName()),
+                                          ConstantAsMetadata::get(UndefValue::get(ST))}));
+}
+
+bool writeModule(const Module &M, StringRef Path, uint32_t &Size) {
+  // scriviamo in un file temporaneo e lo rinominiamo: chi legge vede il
+  // file intero o nessun file
+  SmallString<128> TmpPath;
+  int TmpFD;
+  if (sys::fs::createUniqueFile(Path + ".%%%%%%.tmp", TmpFD, TmpPath))
+    return false;
+  {
+    raw_fd_ostream OS(TmpFD, /*shouldClose=*/true);
+    WriteBitcodeToFile(M, OS);
+    Size = OS.tell();
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TmpPath);
+      return false;
+    }
+  }
+  if (sys::fs::rename(TmpPath, Path)) {
+    sys::fs::remove(TmpPath);
+    return false;
+  }
+  return true;
+}
+
+// Sostituisce il corpo di F con quello della funzione omonima di Cached
+bool spliceFunction(Module &Cached, Function &F) {
+  Function *CF = Cached.getFunction(F.getName());
+  if (!CF || CF->isDeclaration())
+    return false;
+  LLVMContext &Ctx = F.getContext();
+  StructRemapper Types;
+  if (NamedMDNode *Table = Cached.getNamedMetadata(TypeTableName)) {
+    for (MDNode *N : Table->operands()) {
+      auto *Name = dyn_cast<MDString>(N->getOperand(0));
+      auto *Loaded = mdconst::dyn_extract<Constant>(N->getOperand(1));
+      StructType *Orig = Name ? StructType::getTypeByName(Ctx, Name->getString()) : nullptr;
+      if (!Loaded || !Orig)
+        return false;
+      Types.add(Loaded->getType(), Orig);
+    }
+  }
+  if (Types.remapType(CF->getFunctionType()) != F.getFunctionType())
+    return false;
+
+  // i globali si ricollegano per nome; mancano solo le dichiarazioni
+  // aggiunte dal pass (per esempio intrinseche usate da SCEVExpander)
+  Module &M = *F.getParent();
+  ValueToValueMapTy VMap;
+  SmallVector<Function *, 4> Missing;
+  for (GlobalValue &GV : Cached.global_values()) {
+    if (&GV == CF) {
+      VMap[&GV] = &F;
+      continue;
+    }
+    GlobalValue *Target = M.getNamedValue(GV.getName());
+    if (!Target && isa<Function>(GV) && GV.isDeclaration()) {
+      Missing.push_back(cast<Function>(&GV));
+      continue;
+    }
+    if (!Target || Target->getType() != GV.getType())
+      return false;
+    VMap[&GV] = Target;
+  }
+  for (Function *G : Missing) {
+    auto *FT = cast<FunctionType>(Types.remapType(G->getFunctionType()));
+    Function *Decl = Function::Create(FT, GlobalValue::ExternalLinkage, G->getAddressSpace(),
+                                      G->getName(), &M);
+    if (!Decl->isIntrinsic())
+      Decl->setAttributes(G->getAttributes());
+    VMap[G] = Decl;
+  }
+  auto Arg = F.arg_begin();
+  for (Argument &A : CF->args())
+    VMap[&A] = &*Arg++;
+
+  // gli attributi sono quelli della dichiarazione di F, non della copia
+  AttributeList Attrs = F.getAttributes();
+  F.dropAllReferences();
+  F.clearMetadata();
+  SmallVector<ReturnInst *, 4> Returns;
+  CloneFunctionInto(&F, CF, VMap, CloneFunctionChangeType::LocalChangesOnly, Returns, "",
+                    nullptr, &Types);
+  F.setAttributes(Attrs);
+  return true;
+}
+
+bool loadFunction(StringRef Path, Function &F) {
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer = MemoryBuffer::getFile(Path);
+  if (!Buffer)
+    return false;
+  Expected<std::unique_ptr<Module>> Cached =
+      parseBitcodeFile((*Buffer)->getMemBufferRef(), F.getContext());
+  if (!Cached) {
+    consumeError(Cached.takeError());
+    return false;
+  }
+  return spliceFunction(**Cached, F);
+}
+
+} // namespace
+
+CachedFunction::CachedFunction(Function &F, const Twine &PassConfig) : F(F) {
+  PassCache *Cache = PassCache::get();
+  if (!Cache || F.isDeclaration())
+    return;
+  std::unique_ptr<Module> Extracted = extractFunction(F);
+  if (!Extracted) {
+    ++NumUncacheable;
+    return;
+  }
+
+  std::string Text;
+  raw_string_ostream OS(Text);
+  OS << PassConfig << '\n' << CacheSalt << '\n' << LLVM_VERSION_STRING << '\n';
+  Extracted->print(OS, nullptr);
+  MD5 Hash;
+  Hash.update(OS.str());
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  K.StructHash = StructuralHash(F);
+  memcpy(K.Digest.data(), &Result[0], K.Digest.size());
+  Cacheable = true;
+
+  bool Changed;
+  if (!Cache->lookup(K, Changed) || (Changed && !loadFunction(Cache->getPath(K), F))) {
+    ++NumMisses;
+    return;
+  }
+  ++NumHits;
+  Hit = true;
+  HitChanged = Changed;
+  LLVM_DEBUG(dbgs() << "passcache: " << F.getName() << " dalla cache ("
+                    << PassConfig << ")\n");
+}
+
+PreservedAnalyses CachedFunction::getHitResult() const {
+  return HitChanged ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
+
+void CachedFunction::store(bool Changed) {
+  if (!Cacheable || Hit)
+    return;
+  PassCache *Cache = PassCache::get();
+  uint32_t Size = 0;
+  if (Changed) {
+    std::unique_ptr<Module> Extracted = extractFunction(F);
+    if (!Extracted)
+      return;
+    addTypeTable(*Extracted);
+    if (!writeModule(*Extracted, Cache->getPath(K), Size))
+      return;
+  }
+  Cache->insert(K, Size, Changed);
+  ++NumStores;
+}
+
+PreservedAnalyses CachedFunction::store(PreservedAnalyses PA) {
+  store(!PA.areAllPreserved());
+  return PA;
+}
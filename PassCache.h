@@ -0,0 +1,42 @@
+#ifndef LLVM_TRANSFORMS_PASSCACHE_H
+#define LLVM_TRANSFORMS_PASSCACHE_H
+
+#include "llvm/ADT/Twine.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/PassManager.h"
+#include <array>
+#include <string>
+namespace llvm {
+	// Cache su disco del risultato dei nostri pass di funzione, attiva con
+	// -custom-pass-cache-dir=<dir>. La chiave e' lo StructuralHash della
+	// funzione piu' un MD5 del suo IR, delle dichiarazioni che usa e della
+	// configurazione del pass; il valore e' il corpo trasformato (bitcode).
+	// Uso in un pass:
+	//   CachedFunction Cache(F, "loopfusion;max-runtime-checks=8");
+	//   if (Cache.isHit())
+	//     return Cache.getHitResult();
+	//   ... trasformazione ...
+	//   return Cache.store(PA);
+	class CachedFunction {
+		public :
+			CachedFunction(Function &F, const Twine &PassConfig);
+			// il corpo di F e' gia' quello prodotto dal pass
+			bool isHit() const { return Hit; }
+			PreservedAnalyses getHitResult() const;
+			// salva in cache F dopo il pass; non fa nulla dopo un hit
+			void store(bool Changed);
+			PreservedAnalyses store(PreservedAnalyses PA);
+
+			struct Key {
+				uint64_t StructHash = 0;
+				std::array<uint8_t, 16> Digest = {};
+			};
+		private :
+			Function &F;
+			Key K;
+			bool Cacheable = false;
+			bool Hit = false;
+			bool HitChanged = false;
+	};
+}
+#endif
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""Benchmark di scalabilita' del tempo di compilazione di localopts, looppass
+e loopfusion.
+
+Per ogni dimensione (functions, insts, chain, depth) genera una serie di
+moduli con gen_synthetic_ir.py facendo crescere solo quella dimensione, e li
+passa a `opt -passes=<pass>` (new pass manager). Per ogni punto misura il
+tempo reale (il minimo su --repeat esecuzioni) e la memoria massima del
+processo. Al tempo viene tolto quello di una pipeline vuota sullo stesso
+modulo (parsing e verifica). L'esponente di scalabilita' e' la pendenza della
+retta di regressione di log(tempo) su log(istruzioni del modulo): 1 e'
+lineare, 2 quadratico.
+
+Con --baseline i risultati vengono confrontati con un'esecuzione precedente
+salvata con --json. L'uscita e' 1 se un esponente cresce piu' di
+--exponent-slack, oppure se tempo o memoria al punto piu' grande crescono
+piu' di --tolerance.
+
+Esempi:
+    bench.py --opt build/bin/opt --json base.json
+    bench.py --opt build/bin/opt --baseline base.json
+    bench.py --opt opt --plugin libPasses.so --opt-arg=-opaque-pointers --quick
+"""
+
+import argparse
+import json
+import math
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from gen_synthetic_ir import generate  # noqa: E402
+
+# pipeline per ogni pass; looppass e' un LOOP_PASS e opt lo avvolge da solo
+PIPELINES = {
+    "localopts": "localopts",
+    "looppass": "looppass",
+    "loopfusion": "loopfusion",
+}
+NOOP_PIPELINE = "no-op-module"
+
+# punto di partenza: ogni serie fa crescere una sola dimensione
+BASE = {"functions": 4, "insts": 32, "chain": 4, "depth": 1}
+SWEEPS = {
+    "functions": [1, 2, 4, 8, 16, 32, 64],
+    "insts": [8, 16, 32, 64, 128, 256, 512],
+    "chain": [2, 4, 8, 16, 32, 64],
+    "depth": [1, 2, 3, 4, 5, 6],
+}
+QUICK_SWEEPS = {
+    "functions": [1, 4, 16],
+    "insts": [8, 32, 128],
+    "chain": [2, 8, 32],
+    "depth": [1, 2, 3],
+}
+
+# sotto questa soglia le differenze di tempo sono rumore
+MIN_TIME = 1e-3
+
+
+def run_opt(cmd, repeat):
+    """Esegue cmd `repeat` volte; restituisce (tempo minimo in s, memoria massima in KiB)."""
+    best, peak = math.inf, 0
+    for _ in range(repeat):
+        with tempfile.TemporaryFile() as err:
+            start = time.perf_counter()
+            proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=err)
+            _, status, usage = os.wait4(proc.pid, 0)
+            elapsed = time.perf_counter() - start
+            proc.returncode = os.waitstatus_to_exitcode(status)
+            if proc.returncode != 0:
+                err.seek(0)
+                sys.exit(f"errore: {' '.join(cmd)} -> {proc.returncode}\n"
+                         + err.read().decode(errors="replace"))
+        best = min(best, elapsed)
+        # ru_maxrss e' in byte su macOS, in KiB altrove
+        rss = usage.ru_maxrss // 1024 if sys.platform == "darwin" else usage.ru_maxrss
+        peak = max(peak, rss)
+    return best, peak
+
+
+def fit_exponent(points):
+    """Pendenza ai minimi quadrati di log(net) su log(insts)."""
+    xs = [math.log(p["insts"]) for p in points]
+    ys = [math.log(max(p["net"], MIN_TIME)) for p in points]
+    n = len(xs)
+    if n < 2:
+        return 0.0
+    mx, my = sum(xs) / n, sum(ys) / n
+    den = sum((x - mx) ** 2 for x in xs)
+    if den == 0:
+        return 0.0
+    return sum((x - mx) * (y - my) for x, y in zip(xs, ys)) / den
+
+
+def run_sweep(args, opt_cmd, pass_name, pipeline, dim, values, workdir):
+    points = []
+    for value in values:
+        params = dict(BASE)
+        params[dim] = value
+        text, insts = generate(params["functions"], params["insts"],
+                               params["chain"], params["depth"], args.trip)
+        path = os.path.join(workdir, f"{dim}-{value}.ll")
+        if not os.path.exists(path):
+            with open(path, "w") as out:
+                out.write(text)
+        noop, _ = run_opt(opt_cmd + [f"-passes={NOOP_PIPELINE}", path], args.repeat)
+        wall, rss = run_opt(opt_cmd + [f"-passes={pipeline}", path], args.repeat)
+        points.append({"value": value, "insts": insts, "wall": wall,
+                       "net": max(wall - noop, 0.0), "rss_kib": rss})
+        print(f"  {pass_name:<12} {dim:<10} {value:>5} {insts:>9} "
+              f"{wall * 1e3:>10.1f} {points[-1]['net'] * 1e3:>10.1f} {rss / 1024:>9.1f}",
+              flush=True)
+    return {"points": points, "exponent": fit_exponent(points),
+            "net": points[-1]["net"], "rss_kib": points[-1]["rss_kib"]}
+
+
+def compare(results, baseline, args):
+    """Elenco delle regressioni rispetto a baseline."""
+    regressions = []
+    for pass_name, dims in results.items():
+        for dim, res in dims.items():
+            base = baseline.get(pass_name, {}).get(dim)
+            where = f"{pass_name}/{dim}"
+            if args.max_exponent is not None and res["exponent"] > args.max_exponent:
+                regressions.append(f"{where}: esponente {res['exponent']:.2f} > {args.max_exponent:.2f}")
+            if base is None:
+                continue
+            if res["exponent"] > base["exponent"] + args.exponent_slack:
+                regressions.append(f"{where}: esponente {base['exponent']:.2f} -> {res['exponent']:.2f}")
+            if (res["net"] > base["net"] * (1 + args.tolerance)
+                    and res["net"] - base["net"] > args.min_delta):
+                regressions.append(f"{where}: tempo {base['net'] * 1e3:.1f} ms -> {res['net'] * 1e3:.1f} ms")
+            if res["rss_kib"] > base["rss_kib"] * (1 + args.tolerance):
+                regressions.append(f"{where}: memoria {base['rss_kib'] / 1024:.1f} MiB -> "
+                                   f"{res['rss_kib'] / 1024:.1f} MiB")
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--opt", default="opt", help="eseguibile opt")
+    parser.add_argument("--plugin", help="libreria da caricare con -load-pass-plugin")
+    parser.add_argument("--opt-arg", action="append", default=[],
+                        help="argomento aggiuntivo per opt (ripetibile)")
+    parser.add_argument("--passes", default=",".join(PIPELINES),
+                        help="pass da misurare; nome oppure nome=pipeline")
+    parser.add_argument("--dims", default=",".join(SWEEPS),
+                        help="dimensioni da far crescere")
+    parser.add_argument("--quick", action="store_true", help="serie corte, per prove")
+    parser.add_argument("--repeat", type=int, default=3)
+    parser.add_argument("--trip", type=int, default=64, help="iterazioni di ogni loop")
+    parser.add_argument("--json", help="salva i risultati (da usare come --baseline)")
+    parser.add_argument("--baseline", help="risultati di riferimento")
+    parser.add_argument("--tolerance", type=float, default=0.25,
+                        help="crescita relativa ammessa di tempo e memoria")
+    parser.add_argument("--min-delta", type=float, default=0.005,
+                        help="crescita assoluta di tempo (s) sotto cui non c'e' regressione")
+    parser.add_argument("--exponent-slack", type=float, default=0.25,
+                        help="crescita ammessa dell'esponente di scalabilita'")
+    parser.add_argument("--max-exponent", type=float,
+                        help="esponente massimo ammesso anche senza baseline")
+    args = parser.parse_args()
+
+    opt_cmd = [args.opt, "-disable-output"] + args.opt_arg
+    if args.plugin:
+        opt_cmd.append(f"-load-pass-plugin={args.plugin}")
+    sweeps = QUICK_SWEEPS if args.quick else SWEEPS
+    passes = {}
+    for item in args.passes.split(","):
+        name, _, pipeline = item.partition("=")
+        passes[name] = pipeline or PIPELINES.get(name, name)
+    dims = args.dims.split(",")
+    for dim in dims:
+        if dim not in sweeps:
+            parser.error(f"dimensione sconosciuta: {dim}")
+
+    results = {}
+    print(f"  {'pass':<12} {'dim':<10} {'value':>5} {'insts':>9} "
+          f"{'wall ms':>10} {'net ms':>10} {'peak MiB':>9}")
+    with tempfile.TemporaryDirectory() as workdir:
+        for name, pipeline in passes.items():
+            results[name] = {}
+            for dim in dims:
+                res = run_sweep(args, opt_cmd, name, pipeline, dim, sweeps[dim], workdir)
+                results[name][dim] = res
+                print(f"  {name:<12} {dim:<10} esponente {res['exponent']:.2f}", flush=True)
+
+    if args.json:
+        with open(args.json, "w") as out:
+            json.dump({"base": BASE, "trip": args.trip, "results": results}, out, indent=2)
+
+    if args.baseline or args.max_exponent is not None:
+        baseline = {}
+        if args.baseline:
+            with open(args.baseline) as inp:
+                baseline = json.load(inp)["results"]
+        regressions = compare(results, baseline, args)
+        if regressions:
+            print("\nregressioni:")
+            for r in regressions:
+                print("  " + r)
+            return 1
+        print("\nnessuna regressione")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,143 @@
+#!/usr/bin/env python3
+"""Generatore di moduli IR sintetici per misurare il tempo di compilazione.
+
+Ogni modulo contiene N funzioni. Ogni funzione e' una catena di K loop
+adiacenti con lo stesso numero di iterazioni (candidati per loopfusion).
+Ogni loop della catena e' un nest di profondita' D, e il corpo piu' interno
+ha M istruzioni aritmetiche. Le istruzioni ricalcano i pattern di
+localopts (identita' algebriche, moltiplicazioni per potenze di due o quasi,
+coppie add/sub) e contengono calcoli invarianti per looppass.
+
+I loop hanno la forma prodotta da clang -O0 seguito da mem2reg:
+header con PHI e confronto, corpo, latch separato, uscita che fa da
+preheader del loop successivo.
+
+Uso:
+    gen_synthetic_ir.py --functions 4 --insts 32 --chain 3 --depth 2 -o out.ll
+"""
+
+import argparse
+import sys
+
+# pattern ripetuti nel corpo: (testo, quante istruzioni produce)
+# {v} e' il valore corrente, {t} un nome temporaneo, {n} l'argomento invariante
+PATTERNS = [
+    ("{t} = mul nsw i32 {v}, 8", 1),            # strength reduction
+    ("{t} = add nsw i32 {v}, 0", 1),            # identita'
+    ("{t}.a = add nsw i32 {v}, 7\n"
+     "  {t} = sub nsw i32 {t}.a, 7", 2),        # multi-instruction
+    ("{t} = mul nsw i32 {v}, 15", 1),           # quasi potenza di due
+    ("{t}.inv = mul nsw i32 {n}, 3\n"
+     "  {t} = add nsw i32 {v}, {t}.inv", 2),    # invariante nel loop
+    ("{t} = sdiv i32 {v}, 4", 1),
+    ("{t} = mul nsw i32 {v}, 1", 1),            # identita'
+]
+
+
+class Emitter:
+    def __init__(self):
+        self.lines = []
+        self.insts = 0
+
+    def block(self, name):
+        self.lines.append(name + ":")
+
+    def inst(self, text, count=1):
+        self.lines.append("  " + text)
+        self.insts += count
+
+
+def emit_body(e, prefix, ivs, arrays, k, insts, trip):
+    # indice linearizzato (((i1 * T) + i2) * T + i3) ...
+    idx = ivs[0]
+    for d, iv in enumerate(ivs[1:], 1):
+        e.inst(f"%{prefix}.row{d} = mul nsw i64 {idx}, {trip}")
+        e.inst(f"%{prefix}.idx{d} = add nsw i64 %{prefix}.row{d}, {iv}")
+        idx = f"%{prefix}.idx{d}"
+    e.inst(f"%{prefix}.src = getelementptr inbounds i32, ptr {arrays[k]}, i64 {idx}")
+    e.inst(f"%{prefix}.v0 = load i32, ptr %{prefix}.src, align 4")
+    v = f"%{prefix}.v0"
+    emitted = 0
+    p = 0
+    while emitted < insts:
+        text, count = PATTERNS[p % len(PATTERNS)]
+        t = f"%{prefix}.t{p}"
+        e.inst(text.format(t=t, v=v, n="%n"), count)
+        v = t
+        emitted += count
+        p += 1
+    e.inst(f"%{prefix}.dst = getelementptr inbounds i32, ptr {arrays[k + 1]}, i64 {idx}")
+    e.inst(f"store i32 {v}, ptr %{prefix}.dst, align 4")
+
+
+def emit_nest(e, prefix, level, depth, ivs, arrays, k, insts, trip, ph, exit_bb):
+    """Nest a partire dal livello `level`; `ph` e' il preheader, `exit_bb` l'uscita."""
+    name = f"{prefix}.d{level}"
+    iv = f"%{name}.iv"
+    e.block(f"{name}.header")
+    e.inst(f"{iv} = phi i64 [ 0, %{ph} ], [ {iv}.next, %{name}.latch ]")
+    e.inst(f"%{name}.cmp = icmp slt i64 {iv}, {trip}")
+    e.inst(f"br i1 %{name}.cmp, label %{name}.body, label %{exit_bb}")
+    e.block(f"{name}.body")
+    if level + 1 < depth:
+        e.inst(f"br label %{prefix}.d{level + 1}.header")
+        emit_nest(e, prefix, level + 1, depth, ivs + [iv], arrays, k, insts, trip,
+                  f"{name}.body", f"{name}.inner.exit")
+        e.block(f"{name}.inner.exit")
+    else:
+        emit_body(e, name, ivs + [iv], arrays, k, insts, trip)
+    e.inst(f"br label %{name}.latch")
+    e.block(f"{name}.latch")
+    e.inst(f"{iv}.next = add nsw i64 {iv}, 1")
+    e.inst(f"br label %{name}.header")
+
+
+def generate(functions, insts, chain, depth, trip=64):
+    """Restituisce (testo del modulo, numero di istruzioni)."""
+    e = Emitter()
+    e.lines.append("; generato da gen_synthetic_ir.py: "
+                   f"functions={functions} insts={insts} chain={chain} depth={depth}")
+    for f in range(functions):
+        arrays = [f"%a{k}" for k in range(chain + 1)]
+        params = ", ".join(f"ptr noalias {a}" for a in arrays)
+        e.lines.append("")
+        e.lines.append(f"define void @f{f}({params}, i32 %n) {{")
+        e.block("entry")
+        e.inst(f"br label %l0.d0.header")
+        ph = "entry"
+        for k in range(chain):
+            # l'uscita del loop k e' il preheader del loop k + 1
+            exit_bb = f"l{k}.exit"
+            emit_nest(e, f"l{k}", 0, depth, [], arrays, k, insts, trip, ph, exit_bb)
+            e.block(exit_bb)
+            if k + 1 < chain:
+                e.inst(f"br label %l{k + 1}.d0.header")
+            ph = exit_bb
+        e.inst("ret void")
+        e.lines.append("}")
+    return "\n".join(e.lines) + "\n", e.insts
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--functions", type=int, default=1, help="funzioni nel modulo (N)")
+    parser.add_argument("--insts", type=int, default=16, help="istruzioni nel corpo di ogni loop (M)")
+    parser.add_argument("--chain", type=int, default=2, help="loop adiacenti fondibili (K)")
+    parser.add_argument("--depth", type=int, default=1, help="profondita' di ogni nest (D)")
+    parser.add_argument("--trip", type=int, default=64, help="iterazioni di ogni loop")
+    parser.add_argument("-o", "--output", default="-")
+    args = parser.parse_args()
+    if min(args.functions, args.insts, args.chain, args.depth, args.trip) < 1:
+        parser.error("tutti i parametri devono essere >= 1")
+
+    text, _ = generate(args.functions, args.insts, args.chain, args.depth, args.trip)
+    if args.output == "-":
+        sys.stdout.write(text)
+    else:
+        with open(args.output, "w") as out:
+            out.write(text)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,213 @@
+#!/usr/bin/env python3
+"""Cerca per ogni kernel le opzioni dei pass che lo rendono piu' veloce.
+
+Lo spazio di ricerca e' la pipeline
+
+    localopts<...>,looppass<...>,loopfusion<...>
+
+in cui ogni pass puo' anche mancare, con le opzioni registrate in
+PassRegistry.def (vedi SPACE). La ricerca e' per coordinate: a turno, per
+ogni pass si provano tutte le sue configurazioni tenendo fisse quelle degli
+altri e si tiene la piu' veloce. Ci si ferma dopo un giro senza
+miglioramenti o dopo --rounds giri. Un candidato sostituisce il migliore
+solo se e' piu' veloce di almeno --min-gain, per non inseguire il rumore.
+
+Ogni gruppo di candidati e' misurato con run.py, con una sola invocazione
+per kernel e taglia e una --variant per candidato. Il migliore corrente e'
+sempre nel gruppo, quindi il confronto avviene sulla stessa esecuzione.
+Valgono gli stessi controlli di run.py: un candidato che non compila o
+cambia il checksum rispetto alla baseline viene scartato.
+
+Alla fine stampa per ogni kernel e taglia la pipeline migliore, da usare con
+opt -passes=... o run.py --variant.
+
+Esempi:
+    autotune.py --sizes 1048576 kernels/fusion_chain.c
+    autotune.py --passes loopfusion --rounds 1 --json best.json
+    autotune.py --opt opt --plugin libPasses.so --opt-arg=-opaque-pointers --llc-arg=-opaque-pointers
+"""
+
+import argparse
+import itertools
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+RUN_PY = os.path.join(HERE, "run.py")
+
+sys.path.insert(0, HERE)
+from run import REPO, is_program  # noqa: E402
+
+# per ogni pass, le opzioni possibili; ogni opzione e' una lista di valori
+# gia' scritti come in pipeline ("" = valore predefinito, non scritto)
+SPACE = {
+    "localopts": [
+        ["near-pow2-dist=0", "", "near-pow2-dist=2", "near-pow2-dist=3", "near-pow2-dist=4"],
+        ["", "no-div"],
+        ["", "no-multi-inst"],
+    ],
+    "looppass": [
+        ["", "max-hoist=1", "max-hoist=2", "max-hoist=4", "max-hoist=8", "max-hoist=16"],
+    ],
+    "loopfusion": [
+        ["", "max-chain=3", "max-chain=4", "max-chain=8"],
+        ["no-allow-guarded", "", "allow-guarded;max-runtime-checks=2",
+         "allow-guarded;max-runtime-checks=4", "allow-guarded;max-runtime-checks=16"],
+    ],
+}
+# ordine dei pass nella pipeline
+ORDER = ["localopts", "looppass", "loopfusion"]
+OFF = None
+
+
+def configs(name):
+    """Tutte le configurazioni di un pass, come stringhe "pass<...>", piu' OFF."""
+    result = [OFF]
+    for combo in itertools.product(*SPACE[name]):
+        params = ";".join(p for p in combo if p)
+        result.append(f"{name}<{params}>" if params else name)
+    return result
+
+
+def pipeline(state):
+    return ",".join(state[name] for name in ORDER if state.get(name) is not OFF)
+
+
+def run_point(args, kernel, size, candidates, workdir):
+    """Misura le pipeline in candidates su un kernel; restituisce pipeline -> mediana."""
+    variants = {f"t{i}": p for i, p in enumerate(candidates)}
+    out = os.path.join(workdir, "run.json")
+    cmd = [sys.executable, RUN_PY, "--cc", args.cc, "--opt", args.opt, "--llc", args.llc,
+           "--warmup", str(args.warmup), "--repeat", str(args.repeat),
+           "--timeout", str(args.timeout), "--json", out, "--only", ",".join(variants)]
+    if size is not None:
+        cmd += ["--sizes", str(size)]
+    if args.plugin:
+        cmd += ["--plugin", args.plugin]
+    if args.build_dir:
+        cmd += ["--build-dir", args.build_dir]
+    cmd += [f"--opt-arg={a}" for a in args.opt_arg] + [f"--llc-arg={a}" for a in args.llc_arg]
+    cmd += [f"--variant={name}={p}" for name, p in variants.items()] + [kernel]
+    # run.py esce con 1 se un candidato fallisce: lo si vede dallo stato nel JSON
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if not os.path.exists(out):
+        raise RuntimeError(" ".join(cmd) + "\n" + proc.stderr.decode(errors="replace"))
+    with open(out) as src:
+        rows = json.load(src)["results"]
+    os.remove(out)
+    times = {}
+    for row in rows:
+        if row.get("status") != "ok":
+            continue
+        if row["variant"] == "baseline":
+            times[""] = row["median"]
+        elif row["variant"] in variants:
+            times[variants[row["variant"]]] = row["median"]
+    return times
+
+
+def tune(args, kernel, size, workdir):
+    state = {name: OFF for name in ORDER}
+    best, best_time, base_time = "", None, None
+    for round_ in range(args.rounds):
+        improved = False
+        for name in args.passes:
+            candidates = []
+            for config in configs(name):
+                candidate = pipeline({**state, name: config})
+                if candidate not in candidates:
+                    candidates.append(candidate)
+            times = run_point(args, kernel, size, candidates, workdir)
+            if "" not in times:
+                raise RuntimeError("la baseline non compila o non gira")
+            base_time = times[""]
+            # il migliore corrente e' rimisurato in questo gruppo
+            current = times.get(best)
+            if current is None:
+                # di solito un timeout: si riparte dalla baseline
+                state = {n: OFF for n in ORDER}
+                best, current = "", base_time
+            for config in configs(name):
+                candidate = pipeline({**state, name: config})
+                t = times.get(candidate)
+                if t is not None and t < current * (1 - args.min_gain):
+                    state[name], best, current = config, candidate, t
+                    improved = True
+            best_time = current
+            print(f"  giro {round_ + 1} {name:<11} {len(candidates):>3} candidati  "
+                  f"migliore {best or 'baseline'}  {base_time / best_time:.2f}x", flush=True)
+        if not improved:
+            break
+    return {"pipeline": best, "median": best_time, "baseline": base_time,
+            "speedup": base_time / best_time if best_time else 0}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("kernels", nargs="*", help="sorgenti C (default: kernels/*.c e LICM.c)")
+    parser.add_argument("--cc", default="clang")
+    parser.add_argument("--opt", default="opt")
+    parser.add_argument("--llc", default="llc")
+    parser.add_argument("--plugin", help="libreria da caricare con -load-pass-plugin")
+    parser.add_argument("--opt-arg", action="append", default=[],
+                        help="argomento aggiuntivo per opt (ripetibile)")
+    parser.add_argument("--llc-arg", action="append", default=[],
+                        help="argomento aggiuntivo per llc (ripetibile)")
+    parser.add_argument("--passes", default=",".join(ORDER),
+                        help="pass da regolare, separati da virgole (default: tutti)")
+    parser.add_argument("--rounds", type=int, default=2,
+                        help="giri massimi sui pass (default: 2)")
+    parser.add_argument("--min-gain", type=float, default=0.02,
+                        help="guadagno minimo per cambiare configurazione (default: 0.02)")
+    parser.add_argument("--sizes", default="1048576",
+                        help="valori di N, separati da virgole")
+    parser.add_argument("--warmup", type=int, default=1)
+    parser.add_argument("--repeat", type=int, default=5)
+    parser.add_argument("--timeout", type=float, default=300)
+    parser.add_argument("--build-dir", help="dove lasciare IR e binari (default: temporanea)")
+    parser.add_argument("--json", help="salva la pipeline migliore di ogni kernel")
+    args = parser.parse_args()
+
+    args.passes = args.passes.split(",")
+    unknown = [p for p in args.passes if p not in SPACE]
+    if unknown:
+        parser.error("pass sconosciuti: " + ", ".join(unknown))
+    args.passes = [p for p in ORDER if p in args.passes]
+    kernels = args.kernels or (
+        sorted(os.path.join(HERE, "kernels", f) for f in os.listdir(os.path.join(HERE, "kernels"))
+               if f.endswith(".c"))
+        + [os.path.join(REPO, "test_assignment3", "LICM.c")])
+    sizes = [int(s) for s in args.sizes.split(",")]
+
+    failures = 0
+    results = []
+    with tempfile.TemporaryDirectory() as workdir:
+        for kernel in kernels:
+            name = os.path.splitext(os.path.basename(kernel))[0]
+            for size in ([None] if is_program(kernel) else sizes):
+                print(f"{name} N={size or '-'}", flush=True)
+                try:
+                    row = tune(args, kernel, size, workdir)
+                except RuntimeError as err:
+                    failures += 1
+                    print(f"{name:<14} {size or '-':>8} ERROR\n{err}", file=sys.stderr)
+                    continue
+                results.append({"kernel": name, "size": size, **row})
+
+    print(f"\n{'kernel':<14} {'N':>8} {'speedup':>8}  pipeline")
+    for row in results:
+        print(f"{row['kernel']:<14} {row['size'] or '-':>8} {row['speedup']:>7.2f}x  "
+              f"{row['pipeline'] or '(nessun pass)'}")
+    if args.json:
+        with open(args.json, "w") as out:
+            json.dump({"rounds": args.rounds, "min_gain": args.min_gain, "results": results},
+                      out, indent=2)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,129 @@
+// Driver dei kernel: warmup, ripetizioni misurate e contatori hardware.
+//
+// Uso: driver WARMUP REPS
+//
+// Stampa una riga per chiave, con un valore per ripetizione:
+//   checksum <hex>
+//   time <s> <s> ...
+//   cycles <n> <n> ...          (solo se perf_event_open e' disponibile)
+//   instructions <n> <n> ...
+//   cache-misses <n> <n> ...
+//
+// Il driver viene compilato senza i pass: solo il kernel cambia fra le
+// varianti.
+#define _GNU_SOURCE
+#include "kernel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define MAX_REPS 1000
+
+struct counter {
+  const char *name;
+  unsigned type;
+  unsigned long long config;
+  int fd;
+  unsigned long long values[MAX_REPS];
+};
+
+static struct counter counters[] = {
+#ifdef __linux__
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1, {0}},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1, {0}},
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1, {0}},
+#endif
+    {NULL, 0, 0, -1, {0}},
+};
+
+// contatore del solo processo, in user space; -1 se il kernel non lo concede
+static int open_counter(struct counter *c) {
+#ifdef __linux__
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = c->type;
+  attr.config = c->config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+  (void)c;
+  return -1;
+#endif
+}
+
+static void counters_ctl(unsigned long request) {
+#ifdef __linux__
+  for (struct counter *c = counters; c->name; c++)
+    if (c->fd >= 0)
+      ioctl(c->fd, request, 0);
+#else
+  (void)request;
+#endif
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "uso: %s WARMUP REPS\n", argv[0]);
+    return 2;
+  }
+  int warmup = atoi(argv[1]), reps = atoi(argv[2]);
+  if (warmup < 0 || reps < 1 || reps > MAX_REPS) {
+    fprintf(stderr, "REPS deve stare fra 1 e %d\n", MAX_REPS);
+    return 2;
+  }
+  static double times[MAX_REPS];
+
+  for (struct counter *c = counters; c->name; c++)
+    c->fd = open_counter(c);
+
+  kernel_init();
+  for (int r = 0; r < warmup; r++)
+    kernel_run();
+  for (int r = 0; r < reps; r++) {
+#ifdef __linux__
+    counters_ctl(PERF_EVENT_IOC_RESET);
+    counters_ctl(PERF_EVENT_IOC_ENABLE);
+#endif
+    double start = now();
+    kernel_run();
+    times[r] = now() - start;
+#ifdef __linux__
+    counters_ctl(PERF_EVENT_IOC_DISABLE);
+#endif
+    for (struct counter *c = counters; c->name; c++)
+      if (c->fd >= 0 && read(c->fd, &c->values[r], sizeof(c->values[r])) != sizeof(c->values[r]))
+        c->fd = -1;
+  }
+
+  printf("checksum %016lx\n", kernel_checksum());
+  printf("time");
+  for (int r = 0; r < reps; r++)
+    printf(" %.9f", times[r]);
+  printf("\n");
+  for (struct counter *c = counters; c->name; c++) {
+    if (c->fd < 0)
+      continue;
+    printf("%s", c->name);
+    for (int r = 0; r < reps; r++)
+      printf(" %llu", c->values[r]);
+    printf("\n");
+  }
+  return 0;
+}
@@ -0,0 +1,36 @@
+#ifndef BENCHMARKS_RUNTIME_KERNEL_H
+#define BENCHMARKS_RUNTIME_KERNEL_H
+
+// Interfaccia dei kernel usati da run.py. Il driver chiama kernel_init una
+// volta, kernel_run per ogni ripetizione (warmup compreso) e kernel_checksum
+// alla fine: il checksum deve essere lo stesso con e senza i pass.
+//
+// N e' la dimensione dei dati, passata con -DN=... perche' loopfusion e
+// loopunrolljam vogliono un numero di iterazioni costante. I kernel 2-D usano
+// SIDE x SIDE elementi, con SIDE la piu' grande potenza di due tale che
+// SIDE * SIDE <= N.
+
+#ifndef N
+#define N 65536
+#endif
+
+#define SIDE                                                                   \
+  (N >= (1L << 24) ? 4096 : N >= (1L << 22) ? 2048 : N >= (1L << 20) ? 1024   \
+   : N >= (1L << 18) ? 512 : N >= (1L << 16) ? 256 : N >= (1L << 14) ? 128    \
+   : N >= (1L << 12) ? 64 : N >= (1L << 10) ? 32 : 16)
+
+void kernel_init(void);
+void kernel_run(void);
+unsigned long kernel_checksum(void);
+
+// FNV-1a sui valori di un array
+static inline unsigned long checksum_array(const unsigned *v, long n) {
+  unsigned long h = 1469598103934665603UL;
+  for (long i = 0; i < n; i++) {
+    h ^= v[i];
+    h *= 1099511628211UL;
+  }
+  return h;
+}
+
+#endif
@@ -0,0 +1,23 @@
+// Somme per colonna: il loop interno scorre le righe, con passo di una riga
+// intera (looptile scambia i loop)
+#include "../kernel.h"
+
+static unsigned A[SIDE][SIDE], s[SIDE];
+
+void kernel_init(void) {
+  for (int i = 0; i < SIDE; i++)
+    for (int j = 0; j < SIDE; j++)
+      A[i][j] = i ^ (j * 3);
+}
+
+void kernel_run(void) {
+  for (int j = 0; j < SIDE; j++)
+    s[j] = 0;
+  for (int j = 0; j < SIDE; j++)
+    for (int i = 0; i < SIDE; i++)
+      s[j] += A[i][j];
+}
+
+unsigned long kernel_checksum(void) {
+  return checksum_array(s, SIDE);
+}
@@ -0,0 +1,23 @@
+// Una ricorrenza e un calcolo indipendente nello stesso loop (loopfission)
+#include "../kernel.h"
+
+static unsigned a[N], b[N], c[N], d[N];
+
+void kernel_init(void) {
+  for (int i = 0; i < N; i++) {
+    b[i] = i * 2246822519u;
+    d[i] = i;
+  }
+  a[0] = 1;
+}
+
+void kernel_run(void) {
+  for (int i = 1; i < N; i++) {
+    a[i] = a[i - 1] * 3 + b[i];
+    c[i] = b[i] * 7 + d[i];
+  }
+}
+
+unsigned long kernel_checksum(void) {
+  return checksum_array(a, N) ^ checksum_array(c, N);
+}
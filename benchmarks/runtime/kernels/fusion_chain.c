@@ -0,0 +1,22 @@
+// Catena di loop adiacenti sullo stesso intervallo (loopfusion)
+#include "../kernel.h"
+
+static unsigned a[N], b[N], c[N], d[N];
+
+void kernel_init(void) {
+  for (int i = 0; i < N; i++)
+    a[i] = i * 2654435761u;
+}
+
+void kernel_run(void) {
+  for (int i = 0; i < N; i++)
+    b[i] = a[i] * 3;
+  for (int i = 0; i < N; i++)
+    c[i] = b[i] + a[i];
+  for (int i = 0; i < N; i++)
+    d[i] = c[i] ^ b[i];
+}
+
+unsigned long kernel_checksum(void) {
+  return checksum_array(c, N) ^ checksum_array(d, N);
+}
@@ -0,0 +1,26 @@
+// Calcoli che non dipendono dal loop (looppass)
+#include "../kernel.h"
+
+static unsigned in[N], out[N];
+static unsigned scale = 12345;
+
+static void body(unsigned k) {
+  for (int i = 0; i < N; i++) {
+    unsigned t = k * 3 + 7;
+    unsigned u = t * t + k;
+    out[i] = in[i] * u + t;
+  }
+}
+
+void kernel_init(void) {
+  for (int i = 0; i < N; i++)
+    in[i] = i * 97u;
+}
+
+void kernel_run(void) {
+  body(scale);
+}
+
+unsigned long kernel_checksum(void) {
+  return checksum_array(out, N);
+}
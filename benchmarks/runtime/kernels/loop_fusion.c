@@ -0,0 +1,19 @@
+// Il kernel di test_assignment4, applicato a blocchi su array di N elementi
+#include "../kernel.h"
+#include "../../../test_assignment4/LoopFusion.c"
+
+static int a[N + 12], b[N + 12];
+
+void kernel_init(void) {
+  for (int i = 0; i < N + 12; i++)
+    a[i] = b[i] = 0;
+}
+
+void kernel_run(void) {
+  for (int k = 0; k + 12 <= N; k += 10)
+    fun(a + k, b + k);
+}
+
+unsigned long kernel_checksum(void) {
+  return checksum_array((const unsigned *)a, N) ^ checksum_array((const unsigned *)b, N);
+}
@@ -0,0 +1,25 @@
+// Prodotto matrice-vettore: x[j] e' lo stesso per tutte le righe
+// (loopunrolljam, looptile)
+#include "../kernel.h"
+
+static unsigned A[SIDE][SIDE], x[SIDE], y[SIDE];
+
+void kernel_init(void) {
+  for (int i = 0; i < SIDE; i++) {
+    x[i] = i * 7 + 1;
+    for (int j = 0; j < SIDE; j++)
+      A[i][j] = (i * 31 + j * 17) & 255;
+  }
+}
+
+void kernel_run(void) {
+  for (int i = 0; i < SIDE; i++)
+    y[i] = 0;
+  for (int i = 0; i < SIDE; i++)
+    for (int j = 0; j < SIDE; j++)
+      y[i] += A[i][j] * x[j];
+}
+
+unsigned long kernel_checksum(void) {
+  return checksum_array(y, SIDE);
+}
@@ -0,0 +1,22 @@
+// Il secondo loop rilegge b[i] e b[i + 1]: dopo la fusione i valori passano
+// da un'iterazione all'altra (loopfusion + loopscalarrepl)
+#include "../kernel.h"
+
+static unsigned a[N], b[N + 1], c[N];
+
+void kernel_init(void) {
+  for (int i = 0; i < N; i++)
+    a[i] = i * 40503u;
+  b[0] = 0;
+}
+
+void kernel_run(void) {
+  for (int i = 0; i < N; i++)
+    b[i + 1] = a[i] * 5 + 1;
+  for (int i = 0; i < N; i++)
+    c[i] = b[i + 1] + b[i];
+}
+
+unsigned long kernel_checksum(void) {
+  return checksum_array(c, N);
+}
@@ -0,0 +1,26 @@
+// Identita' algebriche e moltiplicazioni per costanti (localopts)
+#include "../kernel.h"
+
+static int in[N], out[N];
+
+// valori con segno: z / 4 deve arrotondare verso zero anche per z negativo,
+// e' il caso che una sdiv riscritta in ashr sbaglia
+void kernel_init(void) {
+  for (int i = 0; i < N; i++)
+    in[i] = ((i * 37) & 1023) - 512;
+}
+
+void kernel_run(void) {
+  for (int i = 0; i < N; i++) {
+    int v = in[i];
+    int x = v * 8 + 0;
+    int y = (x + 5) - 5;
+    // 121 * v: non sempre multiplo di 4, la divisione ha un resto
+    int z = y * 15 + v * 1;
+    out[i] = z / 4;
+  }
+}
+
+unsigned long kernel_checksum(void) {
+  return checksum_array((const unsigned *)out, N);
+}
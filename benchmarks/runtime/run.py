@@ -0,0 +1,244 @@
+#!/usr/bin/env python3
+"""Misura quanto i pass rendono piu' veloce il codice, e che non lo rompano.
+
+Ogni kernel C viene compilato una volta per variante:
+
+    clang -O0 -Xclang -disable-O0-optnone -emit-llvm -DN=<size>
+    opt -passes=function(mem2reg)[,<pass>]   (la variante "baseline" e' solo mem2reg)
+    llc -O2
+    link con driver.c (compilato a parte, senza i pass)
+
+e poi eseguito con --warmup ripetizioni scartate e --repeat misurate. Il
+driver riporta tempo, cicli, istruzioni e cache miss (questi ultimi solo se
+perf_event_open e' permesso). Il checksum dei risultati di ogni variante deve
+essere uguale a quello della baseline, altrimenti la riga e' segnata DIFF e
+l'uscita e' 1.
+
+I kernel sono i file in kernels/ (vedi kernel.h per l'interfaccia). I
+sorgenti con un main proprio, come test_assignment3/LICM.c, sono eseguiti
+come programmi interi: si misura solo il tempo e si confronta lo stdout.
+
+Esempi:
+    run.py --sizes 65536,1048576
+    run.py --only loopfusion,loopunrolljam kernels/matvec.c
+    run.py --variant 'fuse+fwd=loopfusion,loopscalarrepl' --json out.json
+    run.py --opt opt --plugin libPasses.so --opt-arg=-opaque-pointers --llc-arg=-opaque-pointers
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import re
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+REPO = os.path.dirname(os.path.dirname(HERE))
+
+BASELINE = "baseline"
+# varianti predefinite: pipeline dopo mem2reg
+VARIANTS = {
+    "localopts": "localopts",
+    "looppass": "looppass",
+    "loopfusion": "loopfusion",
+    "loopfusion+scalarrepl": "loopfusion,loopscalarrepl",
+    "loopfission": "loopfission",
+    "looptile": "looptile",
+    "loopunrolljam": "loopunrolljam",
+}
+COUNTERS = ["cycles", "instructions", "cache-misses"]
+
+
+class BuildError(Exception):
+    pass
+
+
+def run_cmd(cmd):
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    if proc.returncode != 0:
+        raise BuildError(" ".join(cmd) + "\n" + proc.stderr.decode(errors="replace"))
+    return proc.stdout
+
+
+def is_program(path):
+    with open(path, errors="replace") as src:
+        return re.search(r"^\s*int\s+main\s*\(", src.read(), re.M) is not None
+
+
+class Builder:
+    def __init__(self, args, workdir):
+        self.args = args
+        self.workdir = workdir
+        self.opt = [args.opt] + args.opt_arg
+        if args.plugin:
+            self.opt.append(f"-load-pass-plugin={args.plugin}")
+        self.driver = None
+
+    def driver_object(self):
+        if self.driver is None:
+            self.driver = os.path.join(self.workdir, "driver.o")
+            run_cmd([self.args.cc, "-O2", "-c", f"-I{HERE}",
+                     os.path.join(HERE, "driver.c"), "-o", self.driver])
+        return self.driver
+
+    def build(self, kernel, size, variant, pipeline):
+        name = os.path.splitext(os.path.basename(kernel))[0]
+        stem = os.path.join(self.workdir, name if size is None else f"{name}-{size}")
+        ir = stem + ".ll"
+        if not os.path.exists(ir):
+            cmd = [self.args.cc, "-O0", "-Xclang", "-disable-O0-optnone", "-S", "-emit-llvm",
+                   f"-I{HERE}", kernel, "-o", ir]
+            if size is not None:
+                cmd.insert(1, f"-DN={size}")
+            run_cmd(cmd)
+        # mem2reg dentro function(): la pipeline resta di modulo e puo'
+        # contenere pass di modulo (localopts), di funzione e di loop
+        passes = "function(mem2reg)" + ("," + pipeline if pipeline else "")
+        safe = re.sub(r"[^A-Za-z0-9_.+-]", "_", variant)
+        bc, obj, exe = (f"{stem}.{safe}.bc", f"{stem}.{safe}.o", f"{stem}.{safe}")
+        run_cmd(self.opt + [f"-passes={passes}", ir, "-o", bc])
+        run_cmd([self.args.llc, "-O2", "-filetype=obj", "-relocation-model=pic"] + self.args.llc_arg
+                + [bc, "-o", obj])
+        objs = [obj] if size is None else [self.driver_object(), obj]
+        run_cmd([self.args.cc] + objs + ["-o", exe])
+        return exe
+
+
+def run_kernel(exe, args):
+    out = subprocess.run([exe, str(args.warmup), str(args.repeat)], stdout=subprocess.PIPE,
+                         stderr=subprocess.PIPE, timeout=args.timeout)
+    if out.returncode != 0:
+        raise BuildError(f"{exe} -> {out.returncode}\n" + out.stderr.decode(errors="replace"))
+    result = {"counters": {}}
+    for line in out.stdout.decode().splitlines():
+        key, *values = line.split()
+        if key == "checksum":
+            result["check"] = values[0]
+        elif key == "time":
+            result["times"] = [float(v) for v in values]
+        elif key in COUNTERS:
+            result["counters"][key] = statistics.median(int(v) for v in values)
+    return result
+
+
+def run_program(exe, args):
+    times, digest = [], None
+    for r in range(args.warmup + args.repeat):
+        start = time.perf_counter()
+        out = subprocess.run([exe], stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                             timeout=args.timeout)
+        elapsed = time.perf_counter() - start
+        if out.returncode != 0:
+            raise BuildError(f"{exe} -> {out.returncode}\n" + out.stderr.decode(errors="replace"))
+        digest = hashlib.sha1(out.stdout).hexdigest()[:16]
+        if r >= args.warmup:
+            times.append(elapsed)
+    return {"check": digest, "times": times, "counters": {}}
+
+
+def fmt_count(value):
+    return "-" if value is None else f"{value / 1e6:.2f}M"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("kernels", nargs="*", help="sorgenti C (default: kernels/*.c e LICM.c)")
+    parser.add_argument("--cc", default="clang")
+    parser.add_argument("--opt", default="opt")
+    parser.add_argument("--llc", default="llc")
+    parser.add_argument("--plugin", help="libreria da caricare con -load-pass-plugin")
+    parser.add_argument("--opt-arg", action="append", default=[],
+                        help="argomento aggiuntivo per opt (ripetibile)")
+    parser.add_argument("--llc-arg", action="append", default=[],
+                        help="argomento aggiuntivo per llc (ripetibile)")
+    parser.add_argument("--variant", action="append", default=[],
+                        help="variante aggiuntiva NOME=PIPELINE (ripetibile)")
+    parser.add_argument("--only", help="varianti da eseguire, separate da virgole")
+    parser.add_argument("--sizes", default="65536,1048576",
+                        help="valori di N, separati da virgole")
+    parser.add_argument("--warmup", type=int, default=2)
+    parser.add_argument("--repeat", type=int, default=10)
+    parser.add_argument("--timeout", type=float, default=300)
+    parser.add_argument("--build-dir", help="dove lasciare IR e binari (default: temporanea)")
+    parser.add_argument("--json", help="salva i risultati")
+    args = parser.parse_args()
+
+    kernels = args.kernels or (
+        sorted(os.path.join(HERE, "kernels", f) for f in os.listdir(os.path.join(HERE, "kernels"))
+               if f.endswith(".c"))
+        + [os.path.join(REPO, "test_assignment3", "LICM.c")])
+    variants = dict(VARIANTS)
+    for item in args.variant:
+        name, sep, pipeline = item.partition("=")
+        if not sep:
+            parser.error(f"--variant vuole NOME=PIPELINE: {item}")
+        variants[name] = pipeline
+    if args.only:
+        only = args.only.split(",")
+        unknown = [v for v in only if v not in variants]
+        if unknown:
+            parser.error("varianti sconosciute: " + ", ".join(unknown))
+        variants = {v: variants[v] for v in only}
+    variants = {BASELINE: "", **variants}
+    sizes = [int(s) for s in args.sizes.split(",")]
+
+    failures = 0
+    results = []
+    print(f"{'kernel':<14} {'N':>8} {'variant':<22} {'median ms':>10} {'speedup':>8} "
+          f"{'cycles':>9} {'instr':>9} {'c-miss':>9}  check")
+    with tempfile.TemporaryDirectory() as tmp:
+        workdir = args.build_dir or tmp
+        os.makedirs(workdir, exist_ok=True)
+        builder = Builder(args, workdir)
+        for kernel in kernels:
+            program = is_program(kernel)
+            name = os.path.splitext(os.path.basename(kernel))[0]
+            for size in ([None] if program else sizes):
+                base = None
+                for variant, pipeline in variants.items():
+                    row = {"kernel": name, "size": size, "variant": variant}
+                    try:
+                        exe = builder.build(kernel, size, variant, pipeline)
+                        row.update(run_program(exe, args) if program else run_kernel(exe, args))
+                    except (BuildError, subprocess.TimeoutExpired) as err:
+                        failures += 1
+                        row["status"] = "ERROR"
+                        print(f"{name:<14} {size or '-':>8} {variant:<22} ERROR\n{err}",
+                              file=sys.stderr)
+                        if variant == BASELINE:
+                            break
+                        results.append(row)
+                        continue
+                    row["median"] = statistics.median(row["times"])
+                    if variant == BASELINE:
+                        base = row
+                        row["status"] = "ok"
+                    else:
+                        row["status"] = "ok" if row["check"] == base["check"] else "DIFF"
+                        failures += row["status"] != "ok"
+                    speedup = base["median"] / row["median"] if row["median"] > 0 else 0
+                    row["speedup"] = speedup
+                    c = row["counters"]
+                    print(f"{name:<14} {size or '-':>8} {variant:<22} {row['median'] * 1e3:>10.3f} "
+                          f"{speedup:>7.2f}x {fmt_count(c.get('cycles')):>9} "
+                          f"{fmt_count(c.get('instructions')):>9} {fmt_count(c.get('cache-misses')):>9}"
+                          f"  {row['status']}", flush=True)
+                    results.append(row)
+
+    if args.json:
+        with open(args.json, "w") as out:
+            json.dump({"warmup": args.warmup, "repeat": args.repeat, "results": results},
+                      out, indent=2)
+    if failures:
+        print(f"\n{failures} varianti con errori o risultati diversi dalla baseline")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,14 @@
+// Un loop da dividere con loopfission.
+// a[i] e b[i] formano un ciclo di dipendenze (a[i] usa b[i-1], b[i] usa
+// a[i]) e restano nello stesso loop. c[i] non fa parte del ciclo ma legge
+// a[i-1], scritto all'iterazione precedente: il suo loop va messo dopo
+// quello del ciclo, anche se nel sorgente viene prima.
+int a[100], b[100], c[100];
+
+void fission(void) {
+	for(int i=1;i<100;i++){
+		c[i]=a[i-1]*3;
+		a[i]=b[i-1]+1;
+		b[i]=a[i]*2;
+	}
+}
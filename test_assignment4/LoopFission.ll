@@ -0,0 +1,80 @@
+; LoopFission.c dopo mem2reg e instcombine.
+;
+; Tre statement, due partizioni: {a[i], b[i]} (ciclo attraverso b[i-1]) e
+; {c[i]}. c[i] legge a[i-1], quindi la copia del loop con il ciclo
+; (preheader .split.fiss0) viene eseguita per prima e il loop originale,
+; dopo .split, tiene solo lo store su c.
+;
+; RUN: opt -passes='loopfission,verify' -S %s | FileCheck %s
+;
+; CHECK-LABEL: define dso_local void @fission(
+; CHECK-NEXT:  br label %.split.fiss0
+; CHECK:       .split.fiss0:
+; primo loop: il ciclo su a e b, senza lo store su c
+; CHECK:       br i1 %3, label %4, label %.split
+; CHECK-NOT:   ptr @c
+; CHECK:       store i32 %10, ptr %11, align 4
+; CHECK-NEXT:  %12 = load i32, ptr %11, align 4
+; CHECK-NEXT:  %13 = shl nsw i32 %12, 1
+; CHECK-NEXT:  %14 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %7
+; CHECK-NEXT:  store i32 %13, ptr %14, align 4
+; CHECK-NEXT:  br label %15
+; CHECK:       br label %1
+; secondo loop: solo c[i] = a[i-1] * 3
+; CHECK:       .split:
+; CHECK-NEXT:  br label %17
+; CHECK:       %18 = phi i32 [ 1, %.split ], [ %29, %28 ]
+; CHECK:       %23 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %22
+; CHECK-NEXT:  %24 = load i32, ptr %23, align 4
+; CHECK-NEXT:  %25 = mul nsw i32 %24, 3
+; CHECK-NEXT:  %26 = zext i32 %18 to i64
+; CHECK-NEXT:  %27 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %26
+; CHECK-NEXT:  store i32 %25, ptr %27, align 4
+; CHECK-NEXT:  br label %28
+; CHECK:       br label %17
+; CHECK:       30:
+; CHECK-NEXT:  ret void
+
+source_filename = "LoopFission.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@a = dso_local global [100 x i32] zeroinitializer, align 16
+@b = dso_local global [100 x i32] zeroinitializer, align 16
+@c = dso_local global [100 x i32] zeroinitializer, align 16
+
+define dso_local void @fission() {
+  br label %1
+
+1:                                                ; preds = %19, %0
+  %2 = phi i32 [ 1, %0 ], [ %20, %19 ]
+  %3 = icmp ult i32 %2, 100
+  br i1 %3, label %4, label %21
+
+4:                                                ; preds = %1
+  %5 = add nsw i32 %2, -1
+  %6 = zext i32 %5 to i64
+  %7 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %6
+  %8 = load i32, ptr %7, align 4
+  %9 = mul nsw i32 %8, 3
+  %10 = zext i32 %2 to i64
+  %11 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %10
+  store i32 %9, ptr %11, align 4
+  %12 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %6
+  %13 = load i32, ptr %12, align 4
+  %14 = add nsw i32 %13, 1
+  %15 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %10
+  store i32 %14, ptr %15, align 4
+  %16 = load i32, ptr %15, align 4
+  %17 = shl nsw i32 %16, 1
+  %18 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %10
+  store i32 %17, ptr %18, align 4
+  br label %19
+
+19:                                               ; preds = %4
+  %20 = add nuw nsw i32 %2, 1
+  br label %1
+
+21:                                               ; preds = %1
+  ret void
+}
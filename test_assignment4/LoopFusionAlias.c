@@ -0,0 +1,18 @@
+// a e b possono essere in alias: la fusione e' possibile solo dietro un
+// controllo a runtime, e solo se fra i due loop non c'e' una dipendenza a
+// distanza negativa su a
+void fun(int a[], int b[]) {
+	for(int i=0;i<10;i++)
+		a[i]=i;
+
+	for(int i=0;i<10;i++)
+		b[i]=a[i+2]*5;
+}
+
+void fun_same(int a[], int b[]) {
+	for(int i=0;i<10;i++)
+		a[i]=i;
+
+	for(int i=0;i<10;i++)
+		b[i]=a[i]*5;
+}
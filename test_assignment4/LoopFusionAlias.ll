@@ -0,0 +1,115 @@
+; LoopFusionAlias.c dopo mem2reg e instcombine.
+;
+; In @fun il secondo loop legge a[i+2] prima che il primo lo scriva: la
+; dipendenza su a non e' "confused" e DA non ha livelli in comune fra i due
+; loop, la distanza (-2) la calcola SCEV. Non si fonde, nemmeno dietro il
+; controllo fra a e b. In @fun_same la distanza e' 0: si fonde, con il
+; controllo a runtime fra a e b.
+;
+; RUN: opt -passes='loopfusion,verify' -S %s | FileCheck %s
+;
+; CHECK-LABEL: define dso_local void @fun(
+; CHECK-NOT:   lf.overlap
+; CHECK:       br i1 %4, label %5, label %10
+; CHECK:       br i1 %12, label %13, label %23
+; CHECK-LABEL: define dso_local void @fun_same(
+; CHECK:       %lf.overlap = and i1
+; CHECK-NEXT:  br i1 %lf.overlap, label %.split.nofuse, label %.split
+; il loop fuso: dal corpo del primo si passa al corpo del secondo
+; CHECK:       store i32 %.01, ptr %{{[0-9]+}}, align 4
+; CHECK-NEXT:  br label %[[BODY2:[0-9]+]]
+; CHECK:       [[BODY2]]:
+; CHECK:       load i32, ptr
+; CHECK:       !{!"llvm.loop.fusion.disable"}
+
+source_filename = "LoopFusionAlias.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+define dso_local void @fun(ptr noundef %0, ptr noundef %1) {
+  br label %3
+
+3:                                                ; preds = %8, %2
+  %.01 = phi i32 [ 0, %2 ], [ %9, %8 ]
+  %4 = icmp ult i32 %.01, 10
+  br i1 %4, label %5, label %10
+
+5:                                                ; preds = %3
+  %6 = zext i32 %.01 to i64
+  %7 = getelementptr inbounds i32, ptr %0, i64 %6
+  store i32 %.01, ptr %7, align 4
+  br label %8
+
+8:                                                ; preds = %5
+  %9 = add nuw nsw i32 %.01, 1
+  br label %3
+
+10:                                               ; preds = %3
+  br label %11
+
+11:                                               ; preds = %21, %10
+  %.0 = phi i32 [ 0, %10 ], [ %22, %21 ]
+  %12 = icmp ult i32 %.0, 10
+  br i1 %12, label %13, label %23
+
+13:                                               ; preds = %11
+  %14 = add nuw nsw i32 %.0, 2
+  %15 = zext i32 %14 to i64
+  %16 = getelementptr inbounds i32, ptr %0, i64 %15
+  %17 = load i32, ptr %16, align 4
+  %18 = mul nsw i32 %17, 5
+  %19 = zext i32 %.0 to i64
+  %20 = getelementptr inbounds i32, ptr %1, i64 %19
+  store i32 %18, ptr %20, align 4
+  br label %21
+
+21:                                               ; preds = %13
+  %22 = add nuw nsw i32 %.0, 1
+  br label %11
+
+23:                                               ; preds = %11
+  ret void
+}
+
+define dso_local void @fun_same(ptr noundef %0, ptr noundef %1) {
+  br label %3
+
+3:                                                ; preds = %8, %2
+  %.01 = phi i32 [ 0, %2 ], [ %9, %8 ]
+  %4 = icmp ult i32 %.01, 10
+  br i1 %4, label %5, label %10
+
+5:                                                ; preds = %3
+  %6 = zext i32 %.01 to i64
+  %7 = getelementptr inbounds i32, ptr %0, i64 %6
+  store i32 %.01, ptr %7, align 4
+  br label %8
+
+8:                                                ; preds = %5
+  %9 = add nuw nsw i32 %.01, 1
+  br label %3
+
+10:                                               ; preds = %3
+  br label %11
+
+11:                                               ; preds = %19, %10
+  %.0 = phi i32 [ 0, %10 ], [ %20, %19 ]
+  %12 = icmp ult i32 %.0, 10
+  br i1 %12, label %13, label %21
+
+13:                                               ; preds = %11
+  %14 = zext i32 %.0 to i64
+  %15 = getelementptr inbounds i32, ptr %0, i64 %14
+  %16 = load i32, ptr %15, align 4
+  %17 = mul nsw i32 %16, 5
+  %18 = getelementptr inbounds i32, ptr %1, i64 %14
+  store i32 %17, ptr %18, align 4
+  br label %19
+
+19:                                               ; preds = %13
+  %20 = add nuw nsw i32 %.0, 1
+  br label %11
+
+21:                                               ; preds = %11
+  ret void
+}
@@ -0,0 +1,23 @@
+// Metadati di parallelismo lasciati da loopfusion-annotate e da loopfusion.
+//  - parallelo: nessuna dipendenza fra iterazioni, va marcato;
+//  - ricorrenza: a[i] dipende da a[i-1], non va marcato;
+//  - fusi: due loop che loopfusion fonde, il loop fuso e' parallelo.
+int a[100], b[100], c[100];
+
+void parallelo(void) {
+	for(int i=0;i<100;i++)
+		a[i]=b[i]+1;
+}
+
+void ricorrenza(void) {
+	for(int i=1;i<100;i++)
+		a[i]=a[i-1]+b[i];
+}
+
+void fusi(void) {
+	for(int i=0;i<100;i++)
+		a[i]=b[i]+1;
+
+	for(int i=0;i<100;i++)
+		c[i]=a[i]*2;
+}
@@ -0,0 +1,166 @@
+; LoopFusionAnnotate.c dopo mem2reg e instcombine.
+;
+; loopfusion-annotate non fonde niente: marca ogni loop innermost senza
+; dipendenze portate con un access group su load e store, il loop ID con
+; llvm.loop.parallel_accesses su quel gruppo e llvm.loop.vectorize.enable.
+; ricorrenza legge a[i-1] scritto all'iterazione precedente e resta senza
+; metadati. loopfusion marca solo il loop fuso, con un unico gruppo per i
+; due corpi.
+;
+; RUN: opt -passes='loopfusion-annotate,verify' -S %s | FileCheck %s --check-prefix=ANN
+; RUN: opt -passes='loopfusion,verify' -S %s | FileCheck %s --check-prefix=FUSED
+;
+; ANN-LABEL: define dso_local void @parallelo(
+; ANN:       %7 = load i32, ptr %6, align 4, !llvm.access.group [[G1:![0-9]+]]
+; ANN:       store i32 %8, ptr %9, align 4, !llvm.access.group [[G1]]
+; ANN:       br label %1, !llvm.loop [[L1:![0-9]+]]
+;
+; ANN-LABEL: define dso_local void @ricorrenza(
+; ANN-NOT:   !llvm.access.group
+; ANN-NOT:   !llvm.loop
+; ANN:       ret void
+;
+; ANN-LABEL: define dso_local void @fusi(
+; ANN:       %7 = load i32, ptr %6, align 4, !llvm.access.group [[G2:![0-9]+]]
+; ANN:       store i32 %8, ptr %9, align 4, !llvm.access.group [[G2]]
+; ANN:       br label %1, !llvm.loop [[L2:![0-9]+]]
+; ANN:       %19 = load i32, ptr %18, align 4, !llvm.access.group [[G3:![0-9]+]]
+; ANN:       store i32 %20, ptr %21, align 4, !llvm.access.group [[G3]]
+; ANN:       br label %13, !llvm.loop [[L3:![0-9]+]]
+;
+; ANN:       [[G1]] = distinct !{}
+; ANN:       [[L1]] = distinct !{[[L1]], [[PA1:![0-9]+]], [[VEC:![0-9]+]]}
+; ANN:       [[PA1]] = !{!"llvm.loop.parallel_accesses", [[G1]]}
+; ANN:       [[VEC]] = !{!"llvm.loop.vectorize.enable", i1 true}
+; ANN:       [[G2]] = distinct !{}
+; ANN:       [[L2]] = distinct !{[[L2]], [[PA2:![0-9]+]], [[VEC]]}
+; ANN:       [[PA2]] = !{!"llvm.loop.parallel_accesses", [[G2]]}
+; ANN:       [[G3]] = distinct !{}
+; ANN:       [[L3]] = distinct !{[[L3]], [[PA3:![0-9]+]], [[VEC]]}
+; ANN:       [[PA3]] = !{!"llvm.loop.parallel_accesses", [[G3]]}
+;
+; FUSED-LABEL: define dso_local void @parallelo(
+; FUSED-NOT:   !llvm.loop
+; FUSED-LABEL: define dso_local void @ricorrenza(
+; FUSED-NOT:   !llvm.loop
+; FUSED-LABEL: define dso_local void @fusi(
+; FUSED:       %7 = load i32, ptr %6, align 4, !llvm.access.group [[G:![0-9]+]]
+; FUSED:       store i32 %8, ptr %9, align 4, !llvm.access.group [[G]]
+; FUSED-NEXT:  br label %16
+; FUSED:       br label %1, !llvm.loop [[L:![0-9]+]]
+; FUSED:       16:
+; FUSED:       %19 = load i32, ptr %18, align 4, !llvm.access.group [[G]]
+; FUSED:       store i32 %20, ptr %21, align 4, !llvm.access.group [[G]]
+; FUSED-NEXT:  br label %10
+; FUSED:       [[G]] = distinct !{}
+; FUSED:       [[L]] = distinct !{[[L]], [[PA:![0-9]+]], [[VEC:![0-9]+]]}
+; FUSED:       [[PA]] = !{!"llvm.loop.parallel_accesses", [[G]]}
+; FUSED:       [[VEC]] = !{!"llvm.loop.vectorize.enable", i1 true}
+
+source_filename = "LoopFusionAnnotate.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@a = dso_local global [100 x i32] zeroinitializer, align 16
+@b = dso_local global [100 x i32] zeroinitializer, align 16
+@c = dso_local global [100 x i32] zeroinitializer, align 16
+
+define dso_local void @parallelo() {
+  br label %1
+
+1:                                                ; preds = %10, %0
+  %2 = phi i32 [ 0, %0 ], [ %11, %10 ]
+  %3 = icmp ult i32 %2, 100
+  br i1 %3, label %4, label %12
+
+4:                                                ; preds = %1
+  %5 = zext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4
+  %8 = add nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4
+  br label %10
+
+10:                                               ; preds = %4
+  %11 = add nuw nsw i32 %2, 1
+  br label %1
+
+12:                                               ; preds = %1
+  ret void
+}
+
+define dso_local void @ricorrenza() {
+  br label %1
+
+1:                                                ; preds = %14, %0
+  %2 = phi i32 [ 1, %0 ], [ %15, %14 ]
+  %3 = icmp ult i32 %2, 100
+  br i1 %3, label %4, label %16
+
+4:                                                ; preds = %1
+  %5 = add nsw i32 %2, -1
+  %6 = zext i32 %5 to i64
+  %7 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %6
+  %8 = load i32, ptr %7, align 4
+  %9 = zext i32 %2 to i64
+  %10 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %9
+  %11 = load i32, ptr %10, align 4
+  %12 = add nsw i32 %8, %11
+  %13 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %9
+  store i32 %12, ptr %13, align 4
+  br label %14
+
+14:                                               ; preds = %4
+  %15 = add nuw nsw i32 %2, 1
+  br label %1
+
+16:                                               ; preds = %1
+  ret void
+}
+
+define dso_local void @fusi() {
+  br label %1
+
+1:                                                ; preds = %10, %0
+  %2 = phi i32 [ 0, %0 ], [ %11, %10 ]
+  %3 = icmp ult i32 %2, 100
+  br i1 %3, label %4, label %12
+
+4:                                                ; preds = %1
+  %5 = zext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4
+  %8 = add nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4
+  br label %10
+
+10:                                               ; preds = %4
+  %11 = add nuw nsw i32 %2, 1
+  br label %1
+
+12:                                               ; preds = %1
+  br label %13
+
+13:                                               ; preds = %22, %12
+  %14 = phi i32 [ 0, %12 ], [ %23, %22 ]
+  %15 = icmp ult i32 %14, 100
+  br i1 %15, label %16, label %24
+
+16:                                               ; preds = %13
+  %17 = zext i32 %14 to i64
+  %18 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %17
+  %19 = load i32, ptr %18, align 4
+  %20 = shl nsw i32 %19, 1
+  %21 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %17
+  store i32 %20, ptr %21, align 4
+  br label %22
+
+22:                                               ; preds = %16
+  %23 = add nuw nsw i32 %14, 1
+  br label %13
+
+24:                                               ; preds = %13
+  ret void
+}
@@ -0,0 +1,15 @@
+// Tre loop sugli stessi indici di array globali: nessun controllo a runtime.
+// Con max-chain=3 diventano un solo loop, con il default (2) si fondono
+// solo i primi due.
+int a[100], b[100], c[100];
+
+void chain(void) {
+	for(int i=0;i<100;i++)
+		a[i]=i*3;
+
+	for(int i=0;i<100;i++)
+		b[i]=a[i]+1;
+
+	for(int i=0;i<100;i++)
+		c[i]=b[i]*2;
+}
@@ -0,0 +1,109 @@
+; LoopFusionChain.c dopo mem2reg e instcombine.
+;
+; Con max-chain=3 il primo giro fonde i primi due loop, il secondo giro
+; (analisi ricalcolate) fonde il risultato con il terzo: un solo loop con i
+; tre corpi in fila. Con il default (max-chain=2) il terzo loop resta a se'.
+;
+; RUN: opt -passes='loopfusion<max-chain=3>,verify' -S %s | FileCheck %s --check-prefix=CHAIN3
+; RUN: opt -passes='loopfusion,verify' -S %s | FileCheck %s --check-prefix=CHAIN2
+;
+; CHAIN3-LABEL: define dso_local void @chain(
+; CHAIN3:       br i1 %2, label %3, label %31
+; CHAIN3:       store i32 %4, ptr %6
+; CHAIN3-NEXT:  br label %12
+; il latch del loop fuso, marcato parallelo dopo la fusione
+; CHAIN3:       7:
+; CHAIN3:       br label %1, !llvm.loop
+; CHAIN3:       12:
+; CHAIN3:       store i32 %16, ptr %17
+; CHAIN3-NEXT:  br label %23
+; CHAIN3:       23:
+; CHAIN3:       store i32 %27, ptr %28
+; CHAIN3-NEXT:  br label %7
+; CHAIN3:       31:
+; CHAIN3-NEXT:  ret void
+;
+; CHAIN2-LABEL: define dso_local void @chain(
+; CHAIN2:       br i1 %2, label %3, label %20
+; CHAIN2:       store i32 %4, ptr %6
+; CHAIN2-NEXT:  br label %12
+; CHAIN2:       12:
+; CHAIN2:       store i32 %16, ptr %17
+; CHAIN2-NEXT:  br label %7
+; CHAIN2:       20:
+; CHAIN2-NEXT:  br label %21
+; CHAIN2:       21:
+; CHAIN2:       br i1 %22, label %23, label %31
+
+source_filename = "LoopFusionChain.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@a = dso_local global [100 x i32] zeroinitializer, align 16
+@b = dso_local global [100 x i32] zeroinitializer, align 16
+@c = dso_local global [100 x i32] zeroinitializer, align 16
+
+define dso_local void @chain() {
+  br label %1
+
+1:                                                ; preds = %7, %0
+  %.02 = phi i32 [ 0, %0 ], [ %8, %7 ]
+  %2 = icmp ult i32 %.02, 100
+  br i1 %2, label %3, label %9
+
+3:                                                ; preds = %1
+  %4 = mul nuw nsw i32 %.02, 3
+  %5 = zext i32 %.02 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %4, ptr %6, align 4
+  br label %7
+
+7:                                                ; preds = %3
+  %8 = add nuw nsw i32 %.02, 1
+  br label %1
+
+9:                                                ; preds = %1
+  br label %10
+
+10:                                               ; preds = %18, %9
+  %.01 = phi i32 [ 0, %9 ], [ %19, %18 ]
+  %11 = icmp ult i32 %.01, 100
+  br i1 %11, label %12, label %20
+
+12:                                               ; preds = %10
+  %13 = zext i32 %.01 to i64
+  %14 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %13
+  %15 = load i32, ptr %14, align 4
+  %16 = add nsw i32 %15, 1
+  %17 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %13
+  store i32 %16, ptr %17, align 4
+  br label %18
+
+18:                                               ; preds = %12
+  %19 = add nuw nsw i32 %.01, 1
+  br label %10
+
+20:                                               ; preds = %10
+  br label %21
+
+21:                                               ; preds = %29, %20
+  %.0 = phi i32 [ 0, %20 ], [ %30, %29 ]
+  %22 = icmp ult i32 %.0, 100
+  br i1 %22, label %23, label %31
+
+23:                                               ; preds = %21
+  %24 = zext i32 %.0 to i64
+  %25 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %24
+  %26 = load i32, ptr %25, align 4
+  %27 = shl nsw i32 %26, 1
+  %28 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %24
+  store i32 %27, ptr %28, align 4
+  br label %29
+
+29:                                               ; preds = %23
+  %30 = add nuw nsw i32 %.0, 1
+  br label %21
+
+31:                                               ; preds = %21
+  ret void
+}
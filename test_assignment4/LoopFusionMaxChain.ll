@@ -0,0 +1,88 @@
+; loopfusion<max-chain=3> su tre loop consecutivi con puntatori che
+; potrebbero essere in alias: la prima coppia si fonde solo dietro controlli
+; a runtime. Le copie non fuse lasciate da versionLoops sono marcate con
+; llvm.loop.fusion.disable e il giro successivo non le deve rifondere (ne'
+; versionare di nuovo): il pass deve terminare con un solo controllo.
+;
+; Il terzo loop resta com'era anche con max-chain=3: dopo il versioning il
+; loop fuso sta solo sul ramo veloce, e l'uscita che condivide con le copie
+; non e' piu' dominata dal suo header, quindi non e' control flow
+; equivalent con il terzo loop. Le catene di tre loop (senza controlli a
+; runtime) sono in LoopFusionChain.ll.
+;
+; RUN: opt -passes='loopfusion<max-chain=3>,verify' -S %s | FileCheck %s
+;
+; CHECK-LABEL: define void @fun(
+; CHECK:       %lf.overlap = and i1
+; CHECK-NEXT:  br i1 %lf.overlap, label %entry.split.nofuse, label %entry.split
+; il loop fuso esce direttamente nell'uscita del secondo loop
+; CHECK:       h1:
+; CHECK:       br i1 %c1, label %b1, label %x2
+; CHECK:       b1:
+; CHECK:       br label %b2
+; il terzo loop resta com'era
+; CHECK:       h3:
+; CHECK:       br i1 %c3, label %b3, label %x3
+; CHECK:       l1.nofuse:
+; CHECK-NEXT:  %i.next.nofuse = add nsw i32 %i.nofuse, 1
+; CHECK-NEXT:  br label %h1.nofuse, !llvm.loop [[NOFUSE1:![0-9]+]]
+; CHECK:       l2.nofuse:
+; CHECK-NEXT:  %j.next.nofuse = add nsw i32 %j.nofuse, 1
+; CHECK-NEXT:  br label %h2.nofuse, !llvm.loop [[NOFUSE2:![0-9]+]]
+; CHECK-NOT:   lf.overlap
+; CHECK:       [[NOFUSE1]] = distinct !{[[NOFUSE1]], [[DISABLE:![0-9]+]]}
+; CHECK:       [[DISABLE]] = !{!"llvm.loop.fusion.disable"}
+; CHECK:       [[NOFUSE2]] = distinct !{[[NOFUSE2]], [[DISABLE]]}
+
+define void @fun(ptr %a, ptr %b, ptr %c) {
+entry:
+  br label %h1
+h1:
+  %i = phi i32 [0, %entry], [%i.next, %l1]
+  %c1 = icmp slt i32 %i, 10
+  br i1 %c1, label %b1, label %x1
+b1:
+  %ie = sext i32 %i to i64
+  %pa = getelementptr inbounds i32, ptr %a, i64 %ie
+  store i32 %i, ptr %pa
+  br label %l1
+l1:
+  %i.next = add nsw i32 %i, 1
+  br label %h1
+x1:
+  br label %h2
+h2:
+  %j = phi i32 [0, %x1], [%j.next, %l2]
+  %c2 = icmp slt i32 %j, 10
+  br i1 %c2, label %b2, label %x2
+b2:
+  %je = sext i32 %j to i64
+  %pa2 = getelementptr inbounds i32, ptr %a, i64 %je
+  %v = load i32, ptr %pa2
+  %m = mul nsw i32 %v, 5
+  %pb = getelementptr inbounds i32, ptr %b, i64 %je
+  store i32 %m, ptr %pb
+  br label %l2
+l2:
+  %j.next = add nsw i32 %j, 1
+  br label %h2
+x2:
+  br label %h3
+h3:
+  %k = phi i32 [0, %x2], [%k.next, %l3]
+  %c3 = icmp slt i32 %k, 10
+  br i1 %c3, label %b3, label %x3
+b3:
+  %ke = sext i32 %k to i64
+  %pb3 = getelementptr inbounds i32, ptr %b, i64 %ke
+  %w = load i32, ptr %pb3
+  %n = add nsw i32 %w, 3
+  %pc = getelementptr inbounds i32, ptr %c, i64 %ke
+  store i32 %n, ptr %pc
+  br label %l3
+l3:
+  %k.next = add nsw i32 %k, 1
+  br label %h3
+x3:
+  ret void
+}
@@ -0,0 +1,28 @@
+// Loop con uno store su a e un load da a qualche iterazione dopo (come dopo
+// la fusione di due loop).
+//  - dist1: a[i-1] e' il valore salvato all'iterazione precedente;
+//  - dist2: a[i-2] e' quello salvato due iterazioni prima;
+//  - avanti: a[i+1] non e' ancora stato scritto, il load legge il valore
+//    vecchio e non va sostituito.
+int a[100], b[100], c[100];
+
+void dist1(void) {
+	for(int i=1;i<100;i++){
+		a[i]=b[i]*2;
+		c[i]=a[i-1]+1;
+	}
+}
+
+void dist2(void) {
+	for(int i=2;i<100;i++){
+		a[i]=b[i]*2;
+		c[i]=a[i-2]+1;
+	}
+}
+
+void avanti(void) {
+	for(int i=0;i<99;i++){
+		a[i]=b[i]*2;
+		c[i]=a[i+1]+1;
+	}
+}
@@ -0,0 +1,139 @@
+; LoopScalarReplacement.c dopo mem2reg e instcombine.
+;
+; dist1: il load di a[i-1] diventa un PHI nell'header che porta avanti il
+; valore salvato in a[i]; il primo valore (a[0]) e' letto nel preheader.
+; dist2: due PHI rotanti, inizializzati con a[0] e a[1]; il load legge il
+; secondo della catena.
+; avanti: a[i+1] viene scritto solo all'iterazione successiva, la distanza
+; e' negativa e il load resta.
+;
+; RUN: opt -passes='loopscalarrepl,verify' -S %s | FileCheck %s
+;
+; CHECK-LABEL: define dso_local void @dist1(
+; CHECK-NEXT:  %lsr.init = load i32, ptr @a, align 4
+; CHECK:       %lsr.carry = phi i32 [ %lsr.init, %0 ], [ %8, %15 ]
+; CHECK:       %8 = shl nsw i32 %7, 1
+; CHECK-NEXT:  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+; CHECK-NEXT:  store i32 %8, ptr %9, align 4
+; CHECK-NOT:   load
+; CHECK:       %13 = add nsw i32 %lsr.carry, 1
+;
+; CHECK-LABEL: define dso_local void @dist2(
+; CHECK-NEXT:  %lsr.init = load i32, ptr @a, align 4
+; CHECK-NEXT:  %lsr.init1 = load i32, ptr getelementptr (i8, ptr @a, i64 4), align 4
+; CHECK:       %lsr.carry2 = phi i32 [ %lsr.init, %0 ], [ %lsr.carry, %15 ]
+; CHECK-NEXT:  %lsr.carry = phi i32 [ %lsr.init1, %0 ], [ %8, %15 ]
+; CHECK:       store i32 %8, ptr %9, align 4
+; CHECK-NOT:   load
+; CHECK:       %13 = add nsw i32 %lsr.carry2, 1
+;
+; CHECK-LABEL: define dso_local void @avanti(
+; CHECK-NOT:   lsr.
+; CHECK:       store i32 %8, ptr %9, align 4
+; CHECK:       %12 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %11
+; CHECK-NEXT:  %13 = load i32, ptr %12, align 4
+; CHECK-NEXT:  %14 = add nsw i32 %13, 1
+
+source_filename = "LoopScalarReplacement.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@a = dso_local global [100 x i32] zeroinitializer, align 16
+@b = dso_local global [100 x i32] zeroinitializer, align 16
+@c = dso_local global [100 x i32] zeroinitializer, align 16
+
+define dso_local void @dist1() {
+  br label %1
+
+1:                                                ; preds = %16, %0
+  %2 = phi i32 [ 1, %0 ], [ %17, %16 ]
+  %3 = icmp slt i32 %2, 100
+  br i1 %3, label %4, label %18
+
+4:                                                ; preds = %1
+  %5 = sext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4
+  %8 = shl nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4
+  %10 = add nsw i32 %2, -1
+  %11 = sext i32 %10 to i64
+  %12 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %11
+  %13 = load i32, ptr %12, align 4
+  %14 = add nsw i32 %13, 1
+  %15 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %5
+  store i32 %14, ptr %15, align 4
+  br label %16
+
+16:                                               ; preds = %4
+  %17 = add nsw i32 %2, 1
+  br label %1
+
+18:                                               ; preds = %1
+  ret void
+}
+
+define dso_local void @dist2() {
+  br label %1
+
+1:                                                ; preds = %16, %0
+  %2 = phi i32 [ 2, %0 ], [ %17, %16 ]
+  %3 = icmp slt i32 %2, 100
+  br i1 %3, label %4, label %18
+
+4:                                                ; preds = %1
+  %5 = sext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4
+  %8 = shl nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4
+  %10 = add nsw i32 %2, -2
+  %11 = sext i32 %10 to i64
+  %12 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %11
+  %13 = load i32, ptr %12, align 4
+  %14 = add nsw i32 %13, 1
+  %15 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %5
+  store i32 %14, ptr %15, align 4
+  br label %16
+
+16:                                               ; preds = %4
+  %17 = add nsw i32 %2, 1
+  br label %1
+
+18:                                               ; preds = %1
+  ret void
+}
+
+define dso_local void @avanti() {
+  br label %1
+
+1:                                                ; preds = %16, %0
+  %2 = phi i32 [ 0, %0 ], [ %17, %16 ]
+  %3 = icmp slt i32 %2, 99
+  br i1 %3, label %4, label %18
+
+4:                                                ; preds = %1
+  %5 = sext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4
+  %8 = shl nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4
+  %10 = add nsw i32 %2, 1
+  %11 = sext i32 %10 to i64
+  %12 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %11
+  %13 = load i32, ptr %12, align 4
+  %14 = add nsw i32 %13, 1
+  %15 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %5
+  store i32 %14, ptr %15, align 4
+  br label %16
+
+16:                                               ; preds = %4
+  %17 = add nsw i32 %2, 1
+  br label %1
+
+18:                                               ; preds = %1
+  ret void
+}
@@ -0,0 +1,26 @@
+// Nest perfetti di due loop per looptile.
+//  - colonne: il loop interno scorre a e b per colonne, i loop vanno
+//    scambiati;
+//  - righe: x[j] e' riletto ad ogni riga, il loop interno va diviso in
+//    blocchi che stanno in cache;
+//  - ultima: come righe, ma l'indice di riga serve dopo il nest (PHI di
+//    LCSSA all'uscita), quindi niente tiling.
+void colonne(int *restrict a, int *restrict b, int *restrict x) {
+	for (long i = 0; i < 1000; i++)
+		for (long j = 0; j < 1000; j++)
+			a[j*1024+i] = b[j*1024+i] + x[j];
+}
+
+void righe(int *restrict c, int *restrict A, int *restrict x) {
+	for (long i = 0; i < 1000; i++)
+		for (long j = 0; j < 4096; j++)
+			c[i*4100+j] = A[i*4100+j] + x[j];
+}
+
+long ultima(int *restrict c, int *restrict A, int *restrict x) {
+	long i;
+	for (i = 0; i < 1000; i++)
+		for (long j = 0; j < 4096; j++)
+			c[i*4100+j] = A[i*4100+j] + x[j];
+	return i;
+}
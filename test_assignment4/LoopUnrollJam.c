@@ -0,0 +1,24 @@
+// Nest di due loop per loopunrolljam.
+//  - mv: x[j] e' lo stesso per ogni riga, srotolando il loop esterno lo si
+//    legge una volta per piu' righe;
+//  - buono: ogni iterazione scrive solo la sua cella, il jam e' legale;
+//  - bad: a[i+1][j] = a[i][j+1] + x[j], dipendenza con direzioni (<, >):
+//    nel loop fuso la riga i+1 leggerebbe a[i+1][j+1] prima che la riga i
+//    lo abbia scritto, il nest resta com'era.
+void mv(int *restrict y, int *restrict A, int *restrict x) {
+	for (long i = 0; i < 1000; i++)
+		for (long j = 0; j < 512; j++)
+			y[i] += A[i*512+j] * x[j];
+}
+
+void buono(int *restrict a, int *restrict x) {
+	for (long i = 0; i < 100; i++)
+		for (long j = 0; j < 100; j++)
+			a[i*200+j] = a[i*200+j] + x[j];
+}
+
+void bad(int *restrict a, int *restrict x) {
+	for (long i = 0; i < 100; i++)
+		for (long j = 0; j < 100; j++)
+			a[(i+1)*200+j] = a[i*200+j+1] + x[j];
+}
@@ -0,0 +1,194 @@
+; LoopUnrollJam.c dopo mem2reg e instcombine, con il fattore scelto
+; dall'euristica sui registri (16 registri interi su x86-64).
+;
+; mv: fattore 4 (1000 iterazioni esterne). Le copie 1..3 del corpo usano
+; i+1, i+2, i+3 (uj.iv) e sono fuse in fila nel loop interno originale, il
+; loop esterno avanza di 4.
+; buono: stesso schema, fattore 5 (il piu' grande che divide 100).
+; bad: DependenceAnalysis da' [> <] fra il load e lo store, il controllo di
+; legalita' lo rifiuta e il nest resta com'era.
+;
+; RUN: opt -passes='loopunrolljam,verify' -S %s | FileCheck %s
+;
+; CHECK-LABEL: define dso_local void @mv(
+; CHECK:       %uj.iv1 = add i64 %5, 1
+; CHECK-NEXT:  %uj.iv2 = add i64 %5, 2
+; CHECK-NEXT:  %uj.iv3 = add i64 %5, 3
+; CHECK-NEXT:  br label %8
+; CHECK:       %19 = getelementptr inbounds i32, ptr %0, i64 %5
+; CHECK:       store i32 %21, ptr %19, align 4
+; CHECK-NEXT:  br label %24
+; CHECK:       22:
+; CHECK-NEXT:  %23 = add nsw i64 %9, 1
+; CHECK-NEXT:  br label %8
+; CHECK:       24:
+; CHECK-NEXT:  %25 = mul nsw i64 %uj.iv1, 512
+; CHECK-NEXT:  %26 = add nsw i64 %25, %9
+; CHECK:       %32 = getelementptr inbounds i32, ptr %0, i64 %uj.iv1
+; CHECK:       store i32 %34, ptr %32, align 4
+; CHECK-NEXT:  br label %35
+; CHECK:       35:
+; CHECK-NEXT:  %36 = mul nsw i64 %uj.iv2, 512
+; CHECK:       store i32 %45, ptr %43, align 4
+; CHECK-NEXT:  br label %46
+; CHECK:       46:
+; CHECK-NEXT:  %47 = mul nsw i64 %uj.iv3, 512
+; CHECK:       store i32 %56, ptr %54, align 4
+; CHECK-NEXT:  br label %22
+; CHECK:       %59 = add nsw i64 %5, 4
+; CHECK-NEXT:  br label %4
+;
+; CHECK-LABEL: define dso_local void @buono(
+; CHECK:       %uj.iv4 = add i64 %4, 4
+; CHECK-NOT:   uj.iv5
+; CHECK:       %57 = mul nsw i64 %uj.iv4, 200
+; CHECK:       %69 = add nsw i64 %4, 5
+; CHECK-NEXT:  br label %3
+;
+; CHECK-LABEL: define dso_local void @bad(
+; CHECK-NOT:   uj.iv
+; CHECK:       store i32 %22, ptr %14, align 4
+; CHECK-NEXT:  br label %23
+; CHECK:       %27 = add nsw i64 %4, 1
+; CHECK-NEXT:  br label %3
+
+source_filename = "LoopUnrollJam.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+define dso_local void @mv(ptr noalias %0, ptr noalias %1, ptr noalias %2) {
+  br label %4
+
+4:                                                ; preds = %25, %3
+  %5 = phi i64 [ 0, %3 ], [ %26, %25 ]
+  %6 = icmp slt i64 %5, 1000
+  br i1 %6, label %7, label %27
+
+7:                                                ; preds = %4
+  br label %8
+
+8:                                                ; preds = %22, %7
+  %9 = phi i64 [ 0, %7 ], [ %23, %22 ]
+  %10 = icmp slt i64 %9, 512
+  br i1 %10, label %11, label %24
+
+11:                                               ; preds = %8
+  %12 = mul nsw i64 %5, 512
+  %13 = add nsw i64 %12, %9
+  %14 = getelementptr inbounds i32, ptr %1, i64 %13
+  %15 = load i32, ptr %14, align 4
+  %16 = getelementptr inbounds i32, ptr %2, i64 %9
+  %17 = load i32, ptr %16, align 4
+  %18 = mul nsw i32 %15, %17
+  %19 = getelementptr inbounds i32, ptr %0, i64 %5
+  %20 = load i32, ptr %19, align 4
+  %21 = add nsw i32 %20, %18
+  store i32 %21, ptr %19, align 4
+  br label %22
+
+22:                                               ; preds = %11
+  %23 = add nsw i64 %9, 1
+  br label %8
+
+24:                                               ; preds = %8
+  br label %25
+
+25:                                               ; preds = %24
+  %26 = add nsw i64 %5, 1
+  br label %4
+
+27:                                               ; preds = %4
+  ret void
+}
+
+define dso_local void @buono(ptr noalias %0, ptr noalias %1) {
+  br label %3
+
+3:                                                ; preds = %24, %2
+  %4 = phi i64 [ 0, %2 ], [ %25, %24 ]
+  %5 = icmp slt i64 %4, 100
+  br i1 %5, label %6, label %26
+
+6:                                                ; preds = %3
+  br label %7
+
+7:                                                ; preds = %21, %6
+  %8 = phi i64 [ 0, %6 ], [ %22, %21 ]
+  %9 = icmp slt i64 %8, 100
+  br i1 %9, label %10, label %23
+
+10:                                               ; preds = %7
+  %11 = mul nsw i64 %4, 200
+  %12 = add nsw i64 %11, %8
+  %13 = getelementptr inbounds i32, ptr %0, i64 %12
+  %14 = mul nsw i64 %4, 200
+  %15 = add nsw i64 %14, %8
+  %16 = getelementptr inbounds i32, ptr %0, i64 %15
+  %17 = load i32, ptr %16, align 4
+  %18 = getelementptr inbounds i32, ptr %1, i64 %8
+  %19 = load i32, ptr %18, align 4
+  %20 = add nsw i32 %17, %19
+  store i32 %20, ptr %13, align 4
+  br label %21
+
+21:                                               ; preds = %10
+  %22 = add nsw i64 %8, 1
+  br label %7
+
+23:                                               ; preds = %7
+  br label %24
+
+24:                                               ; preds = %23
+  %25 = add nsw i64 %4, 1
+  br label %3
+
+26:                                               ; preds = %3
+  ret void
+}
+
+define dso_local void @bad(ptr noalias %0, ptr noalias %1) {
+  br label %3
+
+3:                                                ; preds = %26, %2
+  %4 = phi i64 [ 0, %2 ], [ %27, %26 ]
+  %5 = icmp slt i64 %4, 100
+  br i1 %5, label %6, label %28
+
+6:                                                ; preds = %3
+  br label %7
+
+7:                                                ; preds = %23, %6
+  %8 = phi i64 [ 0, %6 ], [ %24, %23 ]
+  %9 = icmp slt i64 %8, 100
+  br i1 %9, label %10, label %25
+
+10:                                               ; preds = %7
+  %11 = add nsw i64 %4, 1
+  %12 = mul nsw i64 %11, 200
+  %13 = add nsw i64 %12, %8
+  %14 = getelementptr inbounds i32, ptr %0, i64 %13
+  %15 = mul nsw i64 %4, 200
+  %16 = add nsw i64 %8, 1
+  %17 = add nsw i64 %15, %16
+  %18 = getelementptr inbounds i32, ptr %0, i64 %17
+  %19 = load i32, ptr %18, align 4
+  %20 = getelementptr inbounds i32, ptr %1, i64 %8
+  %21 = load i32, ptr %20, align 4
+  %22 = add nsw i32 %19, %21
+  store i32 %22, ptr %14, align 4
+  br label %23
+
+23:                                               ; preds = %10
+  %24 = add nsw i64 %8, 1
+  br label %7
+
+25:                                               ; preds = %7
+  br label %26
+
+26:                                               ; preds = %25
+  %27 = add nsw i64 %4, 1
+  br label %3
+
+28:                                               ; preds = %3
+  ret void
+}
@@ -0,0 +1,145 @@
+; ModuleID = 'LoopFusionAlias.ll'
+source_filename = "LoopFusionAlias.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+define dso_local void @fun(ptr noundef %0, ptr noundef %1) {
+  br label %3
+
+3:                                                ; preds = %8, %2
+  %.01 = phi i32 [ 0, %2 ], [ %9, %8 ]
+  %4 = icmp ult i32 %.01, 10
+  br i1 %4, label %5, label %10
+
+5:                                                ; preds = %3
+  %6 = zext i32 %.01 to i64
+  %7 = getelementptr inbounds i32, ptr %0, i64 %6
+  store i32 %.01, ptr %7, align 4
+  br label %8
+
+8:                                                ; preds = %5
+  %9 = add nuw nsw i32 %.01, 1
+  br label %3
+
+10:                                               ; preds = %3
+  br label %11
+
+11:                                               ; preds = %21, %10
+  %.0 = phi i32 [ 0, %10 ], [ %22, %21 ]
+  %12 = icmp ult i32 %.0, 10
+  br i1 %12, label %13, label %23
+
+13:                                               ; preds = %11
+  %14 = add nuw nsw i32 %.0, 2
+  %15 = zext i32 %14 to i64
+  %16 = getelementptr inbounds i32, ptr %0, i64 %15
+  %17 = load i32, ptr %16, align 4
+  %18 = mul nsw i32 %17, 5
+  %19 = zext i32 %.0 to i64
+  %20 = getelementptr inbounds i32, ptr %1, i64 %19
+  store i32 %18, ptr %20, align 4
+  br label %21
+
+21:                                               ; preds = %13
+  %22 = add nuw nsw i32 %.0, 1
+  br label %11
+
+23:                                               ; preds = %11
+  ret void
+}
+
+define dso_local void @fun_same(ptr noundef %0, ptr noundef %1) {
+  %3 = ptrtoint ptr %1 to i64
+  %4 = ptrtoint ptr %0 to i64
+  %5 = add i64 %4, 44
+  %6 = add i64 %3, 44
+  %lf.bound1 = icmp ult i64 %3, %5
+  %lf.bound0 = icmp ult i64 %4, %6
+  %lf.overlap = and i1 %lf.bound0, %lf.bound1
+  br i1 %lf.overlap, label %.split.nofuse, label %.split
+
+.split:                                           ; preds = %2
+  br label %7
+
+7:                                                ; preds = %12, %.split
+  %.01 = phi i32 [ 0, %.split ], [ %13, %12 ]
+  %8 = icmp ult i32 %.01, 10
+  br i1 %8, label %9, label %25
+
+9:                                                ; preds = %7
+  %10 = zext i32 %.01 to i64
+  %11 = getelementptr inbounds i32, ptr %0, i64 %10
+  store i32 %.01, ptr %11, align 4
+  br label %17
+
+12:                                               ; preds = %17
+  %13 = add nuw nsw i32 %.01, 1
+  br label %7
+
+14:                                               ; No predecessors!
+  br label %15
+
+15:                                               ; preds = %23, %14
+  %.0 = phi i32 [ 0, %14 ], [ %24, %23 ]
+  %16 = icmp ult i32 %.01, 10
+  br label %23
+
+17:                                               ; preds = %9
+  %18 = zext i32 %.01 to i64
+  %19 = getelementptr inbounds i32, ptr %0, i64 %18
+  %20 = load i32, ptr %19, align 4
+  %21 = mul nsw i32 %20, 5
+  %22 = getelementptr inbounds i32, ptr %1, i64 %18
+  store i32 %21, ptr %22, align 4
+  br label %12
+
+23:                                               ; preds = %15
+  %24 = add nuw nsw i32 %.01, 1
+  br label %15
+
+25:                                               ; preds = %7, %34
+  ret void
+
+.split.nofuse:                                    ; preds = %2
+  br label %26
+
+26:                                               ; preds = %31, %.split.nofuse
+  %.01.nofuse = phi i32 [ 0, %.split.nofuse ], [ %32, %31 ]
+  %27 = icmp ult i32 %.01.nofuse, 10
+  br i1 %27, label %28, label %33
+
+28:                                               ; preds = %26
+  %29 = zext i32 %.01.nofuse to i64
+  %30 = getelementptr inbounds i32, ptr %0, i64 %29
+  store i32 %.01.nofuse, ptr %30, align 4
+  br label %31
+
+31:                                               ; preds = %28
+  %32 = add nuw nsw i32 %.01.nofuse, 1
+  br label %26, !llvm.loop !0
+
+33:                                               ; preds = %26
+  br label %34
+
+34:                                               ; preds = %42, %33
+  %.0.nofuse = phi i32 [ 0, %33 ], [ %43, %42 ]
+  %35 = icmp ult i32 %.0.nofuse, 10
+  br i1 %35, label %36, label %25
+
+36:                                               ; preds = %34
+  %37 = zext i32 %.0.nofuse to i64
+  %38 = getelementptr inbounds i32, ptr %0, i64 %37
+  %39 = load i32, ptr %38, align 4
+  %40 = mul nsw i32 %39, 5
+  %41 = getelementptr inbounds i32, ptr %1, i64 %37
+  store i32 %40, ptr %41, align 4
+  br label %42
+
+42:                                               ; preds = %36
+  %43 = add nuw nsw i32 %.0.nofuse, 1
+  br label %34, !llvm.loop !2
+}
+
+!0 = distinct !{!0, !1}
+!1 = !{!"llvm.loop.fusion.disable"}
+!2 = distinct !{!2, !1}
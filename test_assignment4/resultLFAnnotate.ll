@@ -0,0 +1,119 @@
+; ModuleID = 'LoopFusionAnnotate.ll'
+source_filename = "LoopFusionAnnotate.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@a = dso_local global [100 x i32] zeroinitializer, align 16
+@b = dso_local global [100 x i32] zeroinitializer, align 16
+@c = dso_local global [100 x i32] zeroinitializer, align 16
+
+define dso_local void @parallelo() {
+  br label %1
+
+1:                                                ; preds = %10, %0
+  %2 = phi i32 [ 0, %0 ], [ %11, %10 ]
+  %3 = icmp ult i32 %2, 100
+  br i1 %3, label %4, label %12
+
+4:                                                ; preds = %1
+  %5 = zext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4, !llvm.access.group !0
+  %8 = add nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4, !llvm.access.group !0
+  br label %10
+
+10:                                               ; preds = %4
+  %11 = add nuw nsw i32 %2, 1
+  br label %1, !llvm.loop !1
+
+12:                                               ; preds = %1
+  ret void
+}
+
+define dso_local void @ricorrenza() {
+  br label %1
+
+1:                                                ; preds = %14, %0
+  %2 = phi i32 [ 1, %0 ], [ %15, %14 ]
+  %3 = icmp ult i32 %2, 100
+  br i1 %3, label %4, label %16
+
+4:                                                ; preds = %1
+  %5 = add nsw i32 %2, -1
+  %6 = zext i32 %5 to i64
+  %7 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %6
+  %8 = load i32, ptr %7, align 4
+  %9 = zext i32 %2 to i64
+  %10 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %9
+  %11 = load i32, ptr %10, align 4
+  %12 = add nsw i32 %8, %11
+  %13 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %9
+  store i32 %12, ptr %13, align 4
+  br label %14
+
+14:                                               ; preds = %4
+  %15 = add nuw nsw i32 %2, 1
+  br label %1
+
+16:                                               ; preds = %1
+  ret void
+}
+
+define dso_local void @fusi() {
+  br label %1
+
+1:                                                ; preds = %10, %0
+  %2 = phi i32 [ 0, %0 ], [ %11, %10 ]
+  %3 = icmp ult i32 %2, 100
+  br i1 %3, label %4, label %12
+
+4:                                                ; preds = %1
+  %5 = zext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4, !llvm.access.group !4
+  %8 = add nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4, !llvm.access.group !4
+  br label %10
+
+10:                                               ; preds = %4
+  %11 = add nuw nsw i32 %2, 1
+  br label %1, !llvm.loop !5
+
+12:                                               ; preds = %1
+  br label %13
+
+13:                                               ; preds = %22, %12
+  %14 = phi i32 [ 0, %12 ], [ %23, %22 ]
+  %15 = icmp ult i32 %14, 100
+  br i1 %15, label %16, label %24
+
+16:                                               ; preds = %13
+  %17 = zext i32 %14 to i64
+  %18 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %17
+  %19 = load i32, ptr %18, align 4, !llvm.access.group !7
+  %20 = shl nsw i32 %19, 1
+  %21 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %17
+  store i32 %20, ptr %21, align 4, !llvm.access.group !7
+  br label %22
+
+22:                                               ; preds = %16
+  %23 = add nuw nsw i32 %14, 1
+  br label %13, !llvm.loop !8
+
+24:                                               ; preds = %13
+  ret void
+}
+
+!0 = distinct !{}
+!1 = distinct !{!1, !2, !3}
+!2 = !{!"llvm.loop.parallel_accesses", !0}
+!3 = !{!"llvm.loop.vectorize.enable", i1 true}
+!4 = distinct !{}
+!5 = distinct !{!5, !6, !3}
+!6 = !{!"llvm.loop.parallel_accesses", !4}
+!7 = distinct !{}
+!8 = distinct !{!8, !9, !3}
+!9 = !{!"llvm.loop.parallel_accesses", !7}
@@ -0,0 +1,78 @@
+; ModuleID = 'LoopFusionChain.ll'
+source_filename = "LoopFusionChain.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@a = dso_local global [100 x i32] zeroinitializer, align 16
+@b = dso_local global [100 x i32] zeroinitializer, align 16
+@c = dso_local global [100 x i32] zeroinitializer, align 16
+
+define dso_local void @chain() {
+  br label %1
+
+1:                                                ; preds = %7, %0
+  %.02 = phi i32 [ 0, %0 ], [ %8, %7 ]
+  %2 = icmp ult i32 %.02, 100
+  br i1 %2, label %3, label %31
+
+3:                                                ; preds = %1
+  %4 = mul nuw nsw i32 %.02, 3
+  %5 = zext i32 %.02 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %4, ptr %6, align 4, !llvm.access.group !0
+  br label %12
+
+7:                                                ; preds = %23
+  %8 = add nuw nsw i32 %.02, 1
+  br label %1, !llvm.loop !1
+
+9:                                                ; No predecessors!
+  br label %10
+
+10:                                               ; preds = %18, %9
+  %.01 = phi i32 [ 0, %9 ], [ %19, %18 ]
+  %11 = icmp ult i32 %.02, 100
+  br label %18
+
+12:                                               ; preds = %3
+  %13 = zext i32 %.02 to i64
+  %14 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %13
+  %15 = load i32, ptr %14, align 4, !llvm.access.group !0
+  %16 = add nsw i32 %15, 1
+  %17 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %13
+  store i32 %16, ptr %17, align 4, !llvm.access.group !0
+  br label %23
+
+18:                                               ; preds = %10
+  %19 = add nuw nsw i32 %.02, 1
+  br label %10
+
+20:                                               ; No predecessors!
+  br label %21
+
+21:                                               ; preds = %29, %20
+  %.0 = phi i32 [ 0, %20 ], [ %30, %29 ]
+  %22 = icmp ult i32 %.02, 100
+  br label %29
+
+23:                                               ; preds = %12
+  %24 = zext i32 %.02 to i64
+  %25 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %24
+  %26 = load i32, ptr %25, align 4, !llvm.access.group !0
+  %27 = shl nsw i32 %26, 1
+  %28 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %24
+  store i32 %27, ptr %28, align 4, !llvm.access.group !0
+  br label %7
+
+29:                                               ; preds = %21
+  %30 = add nuw nsw i32 %.02, 1
+  br label %21
+
+31:                                               ; preds = %1
+  ret void
+}
+
+!0 = distinct !{}
+!1 = distinct !{!1, !2, !3}
+!2 = !{!"llvm.loop.parallel_accesses", !0}
+!3 = !{!"llvm.loop.vectorize.enable", i1 true}
@@ -0,0 +1,65 @@
+; ModuleID = 'LoopFission.ll'
+source_filename = "LoopFission.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@a = dso_local global [100 x i32] zeroinitializer, align 16
+@b = dso_local global [100 x i32] zeroinitializer, align 16
+@c = dso_local global [100 x i32] zeroinitializer, align 16
+
+define dso_local void @fission() {
+  br label %.split.fiss0
+
+.split.fiss0:                                     ; preds = %0
+  br label %1
+
+1:                                                ; preds = %15, %.split.fiss0
+  %2 = phi i32 [ 1, %.split.fiss0 ], [ %16, %15 ]
+  %3 = icmp ult i32 %2, 100
+  br i1 %3, label %4, label %.split
+
+4:                                                ; preds = %1
+  %5 = add nsw i32 %2, -1
+  %6 = zext i32 %5 to i64
+  %7 = zext i32 %2 to i64
+  %8 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %6
+  %9 = load i32, ptr %8, align 4
+  %10 = add nsw i32 %9, 1
+  %11 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %7
+  store i32 %10, ptr %11, align 4
+  %12 = load i32, ptr %11, align 4
+  %13 = shl nsw i32 %12, 1
+  %14 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %7
+  store i32 %13, ptr %14, align 4
+  br label %15
+
+15:                                               ; preds = %4
+  %16 = add nuw nsw i32 %2, 1
+  br label %1
+
+.split:                                           ; preds = %1
+  br label %17
+
+17:                                               ; preds = %28, %.split
+  %18 = phi i32 [ 1, %.split ], [ %29, %28 ]
+  %19 = icmp ult i32 %18, 100
+  br i1 %19, label %20, label %30
+
+20:                                               ; preds = %17
+  %21 = add nsw i32 %18, -1
+  %22 = zext i32 %21 to i64
+  %23 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %22
+  %24 = load i32, ptr %23, align 4
+  %25 = mul nsw i32 %24, 3
+  %26 = zext i32 %18 to i64
+  %27 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %26
+  store i32 %25, ptr %27, align 4
+  br label %28
+
+28:                                               ; preds = %20
+  %29 = add nuw nsw i32 %18, 1
+  br label %17
+
+30:                                               ; preds = %17
+  ret void
+}
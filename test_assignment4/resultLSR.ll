@@ -0,0 +1,108 @@
+; ModuleID = 'LoopScalarReplacement.ll'
+source_filename = "LoopScalarReplacement.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+@a = dso_local global [100 x i32] zeroinitializer, align 16
+@b = dso_local global [100 x i32] zeroinitializer, align 16
+@c = dso_local global [100 x i32] zeroinitializer, align 16
+
+define dso_local void @dist1() {
+  %lsr.init = load i32, ptr @a, align 4
+  br label %1
+
+1:                                                ; preds = %15, %0
+  %lsr.carry = phi i32 [ %lsr.init, %0 ], [ %8, %15 ]
+  %2 = phi i32 [ 1, %0 ], [ %16, %15 ]
+  %3 = icmp slt i32 %2, 100
+  br i1 %3, label %4, label %17
+
+4:                                                ; preds = %1
+  %5 = sext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4
+  %8 = shl nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4
+  %10 = add nsw i32 %2, -1
+  %11 = sext i32 %10 to i64
+  %12 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %11
+  %13 = add nsw i32 %lsr.carry, 1
+  %14 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %5
+  store i32 %13, ptr %14, align 4
+  br label %15
+
+15:                                               ; preds = %4
+  %16 = add nsw i32 %2, 1
+  br label %1
+
+17:                                               ; preds = %1
+  ret void
+}
+
+define dso_local void @dist2() {
+  %lsr.init = load i32, ptr @a, align 4
+  %lsr.init1 = load i32, ptr getelementptr (i8, ptr @a, i64 4), align 4
+  br label %1
+
+1:                                                ; preds = %15, %0
+  %lsr.carry2 = phi i32 [ %lsr.init, %0 ], [ %lsr.carry, %15 ]
+  %lsr.carry = phi i32 [ %lsr.init1, %0 ], [ %8, %15 ]
+  %2 = phi i32 [ 2, %0 ], [ %16, %15 ]
+  %3 = icmp slt i32 %2, 100
+  br i1 %3, label %4, label %17
+
+4:                                                ; preds = %1
+  %5 = sext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4
+  %8 = shl nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4
+  %10 = add nsw i32 %2, -2
+  %11 = sext i32 %10 to i64
+  %12 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %11
+  %13 = add nsw i32 %lsr.carry2, 1
+  %14 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %5
+  store i32 %13, ptr %14, align 4
+  br label %15
+
+15:                                               ; preds = %4
+  %16 = add nsw i32 %2, 1
+  br label %1
+
+17:                                               ; preds = %1
+  ret void
+}
+
+define dso_local void @avanti() {
+  br label %1
+
+1:                                                ; preds = %16, %0
+  %2 = phi i32 [ 0, %0 ], [ %17, %16 ]
+  %3 = icmp slt i32 %2, 99
+  br i1 %3, label %4, label %18
+
+4:                                                ; preds = %1
+  %5 = sext i32 %2 to i64
+  %6 = getelementptr inbounds [100 x i32], ptr @b, i64 0, i64 %5
+  %7 = load i32, ptr %6, align 4
+  %8 = shl nsw i32 %7, 1
+  %9 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %5
+  store i32 %8, ptr %9, align 4
+  %10 = add nsw i32 %2, 1
+  %11 = sext i32 %10 to i64
+  %12 = getelementptr inbounds [100 x i32], ptr @a, i64 0, i64 %11
+  %13 = load i32, ptr %12, align 4
+  %14 = add nsw i32 %13, 1
+  %15 = getelementptr inbounds [100 x i32], ptr @c, i64 0, i64 %5
+  store i32 %14, ptr %15, align 4
+  br label %16
+
+16:                                               ; preds = %4
+  %17 = add nsw i32 %2, 1
+  br label %1
+
+18:                                               ; preds = %1
+  ret void
+}
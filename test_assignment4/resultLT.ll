@@ -0,0 +1,142 @@
+; ModuleID = 'LoopTiling.ll'
+source_filename = "LoopTiling.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+define dso_local void @colonne(ptr noalias %0, ptr noalias %1, ptr noalias %2) {
+  br label %4
+
+4:                                                ; preds = %22, %3
+  %5 = phi i64 [ 0, %3 ], [ %23, %22 ]
+  %6 = icmp slt i64 %5, 1000
+  br i1 %6, label %7, label %24
+
+7:                                                ; preds = %4
+  br label %8
+
+8:                                                ; preds = %20, %7
+  %9 = phi i64 [ 0, %7 ], [ %21, %20 ]
+  %10 = icmp slt i64 %9, 1000
+  br i1 %10, label %11, label %22
+
+11:                                               ; preds = %8
+  %12 = mul nsw i64 %5, 1024
+  %13 = add nsw i64 %12, %9
+  %14 = getelementptr inbounds i32, ptr %1, i64 %13
+  %15 = load i32, ptr %14, align 4
+  %16 = getelementptr inbounds i32, ptr %2, i64 %5
+  %17 = load i32, ptr %16, align 4
+  %18 = add nsw i32 %15, %17
+  %19 = getelementptr inbounds i32, ptr %0, i64 %13
+  store i32 %18, ptr %19, align 4
+  br label %20
+
+20:                                               ; preds = %11
+  %21 = add nsw i64 %9, 1
+  br label %8
+
+22:                                               ; preds = %8
+  %23 = add nsw i64 %5, 1
+  br label %4
+
+24:                                               ; preds = %4
+  ret void
+}
+
+define dso_local void @righe(ptr noalias %0, ptr noalias %1, ptr noalias %2) {
+  br label %tile.header
+
+tile.header:                                      ; preds = %3, %tile.latch
+  %tile.iv = phi i64 [ 0, %3 ], [ %tile.iv.next, %tile.latch ]
+  %tile.rem = sub i64 4096, %tile.iv
+  %tile.last = icmp slt i64 %tile.rem, 1024
+  %tile.next = add i64 %tile.iv, 1024
+  %tile.end = select i1 %tile.last, i64 4096, i64 %tile.next
+  br label %4
+
+4:                                                ; preds = %tile.header, %22
+  %5 = phi i64 [ 0, %tile.header ], [ %23, %22 ]
+  %6 = icmp slt i64 %5, 1000
+  br i1 %6, label %7, label %tile.latch
+
+7:                                                ; preds = %4
+  br label %8
+
+8:                                                ; preds = %20, %7
+  %9 = phi i64 [ %tile.iv, %7 ], [ %21, %20 ]
+  %10 = icmp slt i64 %9, %tile.end
+  br i1 %10, label %11, label %22
+
+11:                                               ; preds = %8
+  %12 = mul nsw i64 %5, 4100
+  %13 = add nsw i64 %12, %9
+  %14 = getelementptr inbounds i32, ptr %1, i64 %13
+  %15 = load i32, ptr %14, align 4
+  %16 = getelementptr inbounds i32, ptr %2, i64 %9
+  %17 = load i32, ptr %16, align 4
+  %18 = add nsw i32 %15, %17
+  %19 = getelementptr inbounds i32, ptr %0, i64 %13
+  store i32 %18, ptr %19, align 4
+  br label %20
+
+20:                                               ; preds = %11
+  %21 = add nsw i64 %9, 1
+  br label %8
+
+22:                                               ; preds = %8
+  %23 = add nsw i64 %5, 1
+  br label %4, !llvm.loop !0
+
+tile.latch:                                       ; preds = %4
+  %tile.iv.next = add i64 %tile.iv, 1024
+  %tile.left = sub i64 4096, %tile.iv
+  %tile.more = icmp sgt i64 %tile.left, 1024
+  br i1 %tile.more, label %tile.header, label %24
+
+24:                                               ; preds = %tile.latch
+  ret void
+}
+
+define dso_local i64 @ultima(ptr noalias %0, ptr noalias %1, ptr noalias %2) {
+  br label %4
+
+4:                                                ; preds = %22, %3
+  %5 = phi i64 [ 0, %3 ], [ %23, %22 ]
+  %6 = icmp slt i64 %5, 1000
+  br i1 %6, label %7, label %24
+
+7:                                                ; preds = %4
+  br label %8
+
+8:                                                ; preds = %20, %7
+  %9 = phi i64 [ 0, %7 ], [ %21, %20 ]
+  %10 = icmp slt i64 %9, 4096
+  br i1 %10, label %11, label %22
+
+11:                                               ; preds = %8
+  %12 = mul nsw i64 %5, 4100
+  %13 = add nsw i64 %12, %9
+  %14 = getelementptr inbounds i32, ptr %1, i64 %13
+  %15 = load i32, ptr %14, align 4
+  %16 = getelementptr inbounds i32, ptr %2, i64 %9
+  %17 = load i32, ptr %16, align 4
+  %18 = add nsw i32 %15, %17
+  %19 = getelementptr inbounds i32, ptr %0, i64 %13
+  store i32 %18, ptr %19, align 4
+  br label %20
+
+20:                                               ; preds = %11
+  %21 = add nsw i64 %9, 1
+  br label %8
+
+22:                                               ; preds = %8
+  %23 = add nsw i64 %5, 1
+  br label %4
+
+24:                                               ; preds = %4
+  %25 = phi i64 [ %5, %4 ]
+  ret i64 %25
+}
+
+!0 = distinct !{!0, !1}
+!1 = !{!"llvm.loop.tile.disable", i32 1}
@@ -0,0 +1,246 @@
+; ModuleID = 'LoopUnrollJam.ll'
+source_filename = "LoopUnrollJam.c"
+target datalayout = "e-m:e-p270:32:32-p271:32:32-p272:64:64-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-pc-linux-gnu"
+
+define dso_local void @mv(ptr noalias %0, ptr noalias %1, ptr noalias %2) {
+  br label %4
+
+4:                                                ; preds = %58, %3
+  %5 = phi i64 [ 0, %3 ], [ %59, %58 ]
+  %6 = icmp slt i64 %5, 1000
+  br i1 %6, label %7, label %60
+
+7:                                                ; preds = %4
+  %uj.iv1 = add i64 %5, 1
+  %uj.iv2 = add i64 %5, 2
+  %uj.iv3 = add i64 %5, 3
+  br label %8
+
+8:                                                ; preds = %22, %7
+  %9 = phi i64 [ 0, %7 ], [ %23, %22 ]
+  %10 = icmp slt i64 %9, 512
+  br i1 %10, label %11, label %57
+
+11:                                               ; preds = %8
+  %12 = mul nsw i64 %5, 512
+  %13 = add nsw i64 %12, %9
+  %14 = getelementptr inbounds i32, ptr %1, i64 %13
+  %15 = load i32, ptr %14, align 4
+  %16 = getelementptr inbounds i32, ptr %2, i64 %9
+  %17 = load i32, ptr %16, align 4
+  %18 = mul nsw i32 %15, %17
+  %19 = getelementptr inbounds i32, ptr %0, i64 %5
+  %20 = load i32, ptr %19, align 4
+  %21 = add nsw i32 %20, %18
+  store i32 %21, ptr %19, align 4
+  br label %24
+
+22:                                               ; preds = %46
+  %23 = add nsw i64 %9, 1
+  br label %8
+
+24:                                               ; preds = %11
+  %25 = mul nsw i64 %uj.iv1, 512
+  %26 = add nsw i64 %25, %9
+  %27 = getelementptr inbounds i32, ptr %1, i64 %26
+  %28 = load i32, ptr %27, align 4
+  %29 = getelementptr inbounds i32, ptr %2, i64 %9
+  %30 = load i32, ptr %29, align 4
+  %31 = mul nsw i32 %28, %30
+  %32 = getelementptr inbounds i32, ptr %0, i64 %uj.iv1
+  %33 = load i32, ptr %32, align 4
+  %34 = add nsw i32 %33, %31
+  store i32 %34, ptr %32, align 4
+  br label %35
+
+35:                                               ; preds = %24
+  %36 = mul nsw i64 %uj.iv2, 512
+  %37 = add nsw i64 %36, %9
+  %38 = getelementptr inbounds i32, ptr %1, i64 %37
+  %39 = load i32, ptr %38, align 4
+  %40 = getelementptr inbounds i32, ptr %2, i64 %9
+  %41 = load i32, ptr %40, align 4
+  %42 = mul nsw i32 %39, %41
+  %43 = getelementptr inbounds i32, ptr %0, i64 %uj.iv2
+  %44 = load i32, ptr %43, align 4
+  %45 = add nsw i32 %44, %42
+  store i32 %45, ptr %43, align 4
+  br label %46
+
+46:                                               ; preds = %35
+  %47 = mul nsw i64 %uj.iv3, 512
+  %48 = add nsw i64 %47, %9
+  %49 = getelementptr inbounds i32, ptr %1, i64 %48
+  %50 = load i32, ptr %49, align 4
+  %51 = getelementptr inbounds i32, ptr %2, i64 %9
+  %52 = load i32, ptr %51, align 4
+  %53 = mul nsw i32 %50, %52
+  %54 = getelementptr inbounds i32, ptr %0, i64 %uj.iv3
+  %55 = load i32, ptr %54, align 4
+  %56 = add nsw i32 %55, %53
+  store i32 %56, ptr %54, align 4
+  br label %22
+
+57:                                               ; preds = %8
+  br label %58
+
+58:                                               ; preds = %57
+  %59 = add nsw i64 %5, 4
+  br label %4
+
+60:                                               ; preds = %4
+  ret void
+}
+
+define dso_local void @buono(ptr noalias %0, ptr noalias %1) {
+  br label %3
+
+3:                                                ; preds = %68, %2
+  %4 = phi i64 [ 0, %2 ], [ %69, %68 ]
+  %5 = icmp slt i64 %4, 100
+  br i1 %5, label %6, label %70
+
+6:                                                ; preds = %3
+  %uj.iv1 = add i64 %4, 1
+  %uj.iv2 = add i64 %4, 2
+  %uj.iv3 = add i64 %4, 3
+  %uj.iv4 = add i64 %4, 4
+  br label %7
+
+7:                                                ; preds = %21, %6
+  %8 = phi i64 [ 0, %6 ], [ %22, %21 ]
+  %9 = icmp slt i64 %8, 100
+  br i1 %9, label %10, label %67
+
+10:                                               ; preds = %7
+  %11 = mul nsw i64 %4, 200
+  %12 = add nsw i64 %11, %8
+  %13 = getelementptr inbounds i32, ptr %0, i64 %12
+  %14 = mul nsw i64 %4, 200
+  %15 = add nsw i64 %14, %8
+  %16 = getelementptr inbounds i32, ptr %0, i64 %15
+  %17 = load i32, ptr %16, align 4
+  %18 = getelementptr inbounds i32, ptr %1, i64 %8
+  %19 = load i32, ptr %18, align 4
+  %20 = add nsw i32 %17, %19
+  store i32 %20, ptr %13, align 4
+  br label %23
+
+21:                                               ; preds = %56
+  %22 = add nsw i64 %8, 1
+  br label %7
+
+23:                                               ; preds = %10
+  %24 = mul nsw i64 %uj.iv1, 200
+  %25 = add nsw i64 %24, %8
+  %26 = getelementptr inbounds i32, ptr %0, i64 %25
+  %27 = mul nsw i64 %uj.iv1, 200
+  %28 = add nsw i64 %27, %8
+  %29 = getelementptr inbounds i32, ptr %0, i64 %28
+  %30 = load i32, ptr %29, align 4
+  %31 = getelementptr inbounds i32, ptr %1, i64 %8
+  %32 = load i32, ptr %31, align 4
+  %33 = add nsw i32 %30, %32
+  store i32 %33, ptr %26, align 4
+  br label %34
+
+34:                                               ; preds = %23
+  %35 = mul nsw i64 %uj.iv2, 200
+  %36 = add nsw i64 %35, %8
+  %37 = getelementptr inbounds i32, ptr %0, i64 %36
+  %38 = mul nsw i64 %uj.iv2, 200
+  %39 = add nsw i64 %38, %8
+  %40 = getelementptr inbounds i32, ptr %0, i64 %39
+  %41 = load i32, ptr %40, align 4
+  %42 = getelementptr inbounds i32, ptr %1, i64 %8
+  %43 = load i32, ptr %42, align 4
+  %44 = add nsw i32 %41, %43
+  store i32 %44, ptr %37, align 4
+  br label %45
+
+45:                                               ; preds = %34
+  %46 = mul nsw i64 %uj.iv3, 200
+  %47 = add nsw i64 %46, %8
+  %48 = getelementptr inbounds i32, ptr %0, i64 %47
+  %49 = mul nsw i64 %uj.iv3, 200
+  %50 = add nsw i64 %49, %8
+  %51 = getelementptr inbounds i32, ptr %0, i64 %50
+  %52 = load i32, ptr %51, align 4
+  %53 = getelementptr inbounds i32, ptr %1, i64 %8
+  %54 = load i32, ptr %53, align 4
+  %55 = add nsw i32 %52, %54
+  store i32 %55, ptr %48, align 4
+  br label %56
+
+56:                                               ; preds = %45
+  %57 = mul nsw i64 %uj.iv4, 200
+  %58 = add nsw i64 %57, %8
+  %59 = getelementptr inbounds i32, ptr %0, i64 %58
+  %60 = mul nsw i64 %uj.iv4, 200
+  %61 = add nsw i64 %60, %8
+  %62 = getelementptr inbounds i32, ptr %0, i64 %61
+  %63 = load i32, ptr %62, align 4
+  %64 = getelementptr inbounds i32, ptr %1, i64 %8
+  %65 = load i32, ptr %64, align 4
+  %66 = add nsw i32 %63, %65
+  store i32 %66, ptr %59, align 4
+  br label %21
+
+67:                                               ; preds = %7
+  br label %68
+
+68:                                               ; preds = %67
+  %69 = add nsw i64 %4, 5
+  br label %3
+
+70:                                               ; preds = %3
+  ret void
+}
+
+define dso_local void @bad(ptr noalias %0, ptr noalias %1) {
+  br label %3
+
+3:                                                ; preds = %26, %2
+  %4 = phi i64 [ 0, %2 ], [ %27, %26 ]
+  %5 = icmp slt i64 %4, 100
+  br i1 %5, label %6, label %28
+
+6:                                                ; preds = %3
+  br label %7
+
+7:                                                ; preds = %23, %6
+  %8 = phi i64 [ 0, %6 ], [ %24, %23 ]
+  %9 = icmp slt i64 %8, 100
+  br i1 %9, label %10, label %25
+
+10:                                               ; preds = %7
+  %11 = add nsw i64 %4, 1
+  %12 = mul nsw i64 %11, 200
+  %13 = add nsw i64 %12, %8
+  %14 = getelementptr inbounds i32, ptr %0, i64 %13
+  %15 = mul nsw i64 %4, 200
+  %16 = add nsw i64 %8, 1
+  %17 = add nsw i64 %15, %16
+  %18 = getelementptr inbounds i32, ptr %0, i64 %17
+  %19 = load i32, ptr %18, align 4
+  %20 = getelementptr inbounds i32, ptr %1, i64 %8
+  %21 = load i32, ptr %20, align 4
+  %22 = add nsw i32 %19, %21
+  store i32 %22, ptr %14, align 4
+  br label %23
+
+23:                                               ; preds = %10
+  %24 = add nsw i64 %8, 1
+  br label %7
+
+25:                                               ; preds = %7
+  br label %26
+
+26:                                               ; preds = %25
+  %27 = add nsw i64 %4, 1
+  br label %3
+
+28:                                               ; preds = %3
+  ret void
+}